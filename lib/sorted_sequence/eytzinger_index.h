@@ -0,0 +1,187 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SORTED_SEQUENCE_EYTZINGER_INDEX_H
+#define SORTED_SEQUENCE_EYTZINGER_INDEX_H
+
+#include "sorted_sequence.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+namespace sorted_sequence {
+
+
+/**
+ * Read side search index over an adaptor, for large sequences that are searched far more
+ * often than modified.
+ *
+ * The index keeps a copy of the elements in Eytzinger (breadth first) order: the elements
+ * a search visits first are packed together at the front, and the next levels can be
+ * prefetched, so a lookup touches few cache lines and its comparison results need not be
+ * branched on. The copy is rebuilt in O(n) by the first lookup after the sequence changed
+ * (see adaptor::modificationStamp), so it pays off only for small elements and while
+ * lookups outnumber modifications by far.
+ *
+ * The sequence has to outlive the index. Lookups rebuild the index in place when it is
+ * stale, so call sync() first when looking up from several threads.
+ */
+template< class Sequence >
+class eytzinger_index {
+public:
+    typedef typename Sequence::value_type   value_type;
+    typedef typename Sequence::size_type    size_type;
+    typedef typename Sequence::index        index;
+    typedef typename Sequence::compare_type compare_type;
+
+    explicit eytzinger_index(const Sequence& sequence)
+        : m_sequence(&sequence)
+        , m_stamp(0)
+    {}
+
+    /// Rebuilds the index if the sequence changed since the last lookup.
+    void sync() const;
+
+    template< class T > index lowerBound(const T& value) const { return search<false>(value); }
+    template< class T > index upperBound(const T& value) const { return search<true>(value); }
+    template< class T >
+    index insertPosition(const T& value, InsertMode mode = InsertLast) const
+    {
+        return mode == InsertFirst ? lowerBound(value) : upperBound(value);
+    }
+
+    template< class T >
+    std::pair<index, index> range(const T& value) const
+    {
+        return std::pair<index, index>(lowerBound(value), upperBound(value));
+    }
+
+    template< class T > bool contains(const T& value) const { return indexOf(value) >= 0; }
+    template< class T > size_type count(const T& value) const;
+    template< class T > index indexOf(const T& value) const;
+    template< class T > index findFirst(const T& value) const { return indexOf(value); }
+
+private:
+    template< bool Upper, class T > index search(const T& value) const;
+    void build(std::size_t k, index* next) const;
+
+    const Sequence* m_sequence;
+    mutable std::uint64_t m_stamp;
+    mutable std::vector<value_type> m_keys;  // Eytzinger order, 1-based
+    mutable std::vector<index> m_positions;  // the sequence position of each key
+    mutable std::vector<compare_type> m_compare; // at most one, Compare may lack a default constructor
+};
+
+
+// implementation
+// ----------------------------------------------------------------------------
+
+template< class Sequence >
+void eytzinger_index<Sequence>::sync() const
+{
+    if( ! m_compare.empty() && m_stamp == m_sequence->modificationStamp() )
+        return;
+
+    const std::size_t n = m_sequence->size();
+    m_compare.clear();
+    m_compare.push_back(m_sequence->compareOperator());
+    m_keys.clear();
+    if( n > 0 )
+        m_keys.resize(n + 1, m_sequence->at(0)); // placeholders, value_type may lack a default constructor
+    m_positions.assign(n + 1, index(-1));
+
+    index next = 0;
+    build(1, &next);
+    m_stamp = m_sequence->modificationStamp();
+}
+
+template< class Sequence >
+void eytzinger_index<Sequence>::build(std::size_t k, index* next) const
+{
+    // an in-order walk of the implicit tree visits the keys in sorted order
+    if( k >= m_keys.size() )
+        return;
+
+    build(2 * k, next);
+    m_keys[k] = m_sequence->at(*next);
+    m_positions[k] = *next;
+    ++*next;
+    build(2 * k + 1, next);
+}
+
+template< class Sequence >
+template< bool Upper, class T >
+typename eytzinger_index<Sequence>::index eytzinger_index<Sequence>::search(const T& value) const
+{
+    sync();
+
+    const std::size_t n = m_keys.empty() ? 0 : m_keys.size() - 1;
+    const value_type* keys = m_keys.data();
+    const compare_type& compare = m_compare.front();
+
+    // four levels further down, the 16 descendants of k are stored next to each other
+    const std::size_t prefetchLevels = 16;
+
+    std::size_t k = 1;
+    while( k <= n ) {
+#if defined(__GNUC__)
+        if( prefetchLevels * k <= n )
+            __builtin_prefetch(keys + prefetchLevels * k);
+#endif
+        // descend right while the key goes before the position searched for
+        const bool right = Upper ? ! compare(value, keys[k]) : compare(keys[k], value);
+        k = 2 * k + std::size_t(right);
+    }
+
+    // the last left turn was at the result: drop the trailing right turns and that one
+#if defined(__GNUC__)
+    k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+#else
+    while( k & 1 )
+        k >>= 1;
+    k >>= 1;
+#endif
+    return k == 0 ? index(n) : m_positions[k];
+}
+
+template< class Sequence >
+template< class T >
+typename eytzinger_index<Sequence>::size_type eytzinger_index<Sequence>::count(const T& value) const
+{
+    const std::pair<index, index> r = range(value);
+    return size_type(std::count(m_sequence->begin() + r.first, m_sequence->begin() + r.second, value));
+}
+
+template< class Sequence >
+template< class T >
+typename eytzinger_index<Sequence>::index eytzinger_index<Sequence>::indexOf(const T& value) const
+{
+    const std::pair<index, index> r = range(value);
+    const auto first = m_sequence->begin() + r.first;
+    const auto last = m_sequence->begin() + r.second;
+    const auto it = std::find(first, last, value);
+    return it == last ? -1 : r.first + index(it - first);
+}
+
+
+} // namespace sorted_sequence
+
+#endif // SORTED_SEQUENCE_EYTZINGER_INDEX_H
@@ -0,0 +1,711 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SORTED_SEQUENCE_ORDER_STATISTIC_TREE_H
+#define SORTED_SEQUENCE_ORDER_STATISTIC_TREE_H
+
+#include "sorted_sequence.h"
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sorted_sequence {
+
+
+/**
+ * Sequence container keeping its elements in the leaves of a B+tree, whose inner nodes
+ * store the element count of each subtree. Access by index, insertion and removal at any
+ * position take O(log n), so it can replace a vector as the Container of an adaptor when
+ * large sequences change often. Nodes take about NodeBytes (a few cache lines).
+ *
+ * Iterators are random access, but they hold a position and look the element up on
+ * every dereference. Like vector iterators they are invalidated by insertion and removal.
+ */
+template< class T, std::size_t NodeBytes = 256 >
+class order_statistic_tree {
+    template< bool Const > class basic_iterator;
+
+public:
+    typedef T                               value_type;
+    typedef std::size_t                     size_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef T&                              reference;
+    typedef const T&                        const_reference;
+    typedef basic_iterator<false>           iterator;
+    typedef basic_iterator<true>            const_iterator;
+
+    order_statistic_tree() : m_root(nullptr), m_size(0) {}
+    order_statistic_tree(const order_statistic_tree& other)
+        : m_root(other.m_root ? clone(other.m_root) : nullptr), m_size(other.m_size) {}
+    order_statistic_tree(order_statistic_tree&& other)
+        : m_root(other.m_root), m_size(other.m_size)
+    {
+        other.m_root = nullptr;
+        other.m_size = 0;
+    }
+    template< class InputIterator >
+    order_statistic_tree(InputIterator first, InputIterator last)
+        : m_root(nullptr), m_size(0)
+    {
+        assign(first, last);
+    }
+    ~order_statistic_tree() { clear(); }
+
+    order_statistic_tree& operator=(order_statistic_tree other)
+    {
+        swap(other);
+        return *this;
+    }
+
+    void swap(order_statistic_tree& other)
+    {
+        std::swap(m_root, other.m_root);
+        std::swap(m_size, other.m_size);
+    }
+
+    /// Replaces the content, building the tree bottom up in O(n).
+    template< class InputIterator >
+    void assign(InputIterator first, InputIterator last);
+    /// Moves all elements out in order, leaving the tree empty.
+    std::vector<T> take_all();
+
+    size_type size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear();
+    void reserve(size_type) {}
+
+    const T& at(size_type i) const { return element(i); }
+    const T& operator[](size_type i) const { return element(i); }
+    T& operator[](size_type i) { return element(i); }
+    const T& front() const { return element(0); }
+    const T& back() const { return element(m_size - 1); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, difference_type(m_size)); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, difference_type(m_size)); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    iterator insert(const_iterator position, const T& value)
+    {
+        insert_at(size_type(position.m_pos), value);
+        return iterator(this, position.m_pos);
+    }
+    iterator insert(const_iterator position, T&& value)
+    {
+        insert_at(size_type(position.m_pos), std::move(value));
+        return iterator(this, position.m_pos);
+    }
+    void push_back(const T& value) { insert_at(m_size, value); }
+    void push_back(T&& value) { insert_at(m_size, std::move(value)); }
+
+    iterator erase(const_iterator position)
+    {
+        erase_at(size_type(position.m_pos));
+        return iterator(this, position.m_pos);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        for( difference_type i = first.m_pos; i < last.m_pos; ++i )
+            erase_at(size_type(first.m_pos));
+        return iterator(this, first.m_pos);
+    }
+    void pop_back() { erase_at(m_size - 1); }
+
+    bool operator==(const order_statistic_tree& other) const
+    {
+        return m_size == other.m_size && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const order_statistic_tree& other) const
+    {
+        return ! operator==(other);
+    }
+
+private:
+    static const int leaf_capacity = NodeBytes / sizeof(T) > 8 ? int(NodeBytes / sizeof(T)) : 8;
+    static const int inner_capacity = NodeBytes / (sizeof(void*) + sizeof(size_type)) > 8
+                                      ? int(NodeBytes / (sizeof(void*) + sizeof(size_type))) : 8;
+
+    struct node {
+        explicit node(bool leaf) : is_leaf(leaf), n(0) {}
+        bool is_leaf;
+        int n; // elements of a leaf, children of an inner node
+    };
+
+    struct leaf : node {
+        leaf() : node(true) {}
+        ~leaf()
+        {
+            for( int i = 0; i < this->n; ++i )
+                item(i).~T();
+        }
+        T& item(int i) { return reinterpret_cast<T*>(&storage)[i]; }
+
+        typename std::aligned_storage<sizeof(T) * leaf_capacity, alignof(T)>::type storage;
+    };
+
+    struct inner : node {
+        inner() : node(false) {}
+        size_type counts[inner_capacity];
+        node* children[inner_capacity];
+    };
+
+    static int capacity(const node* x) { return x->is_leaf ? leaf_capacity : inner_capacity; }
+    static size_type count_of(node* x);
+    static void destroy(node* x);
+    static node* clone(node* x);
+
+    T& element(size_type i) const;
+
+    template< class U > static void leaf_insert(leaf* l, int pos, U&& value);
+    static void leaf_erase(leaf* l, int pos);
+    static void inner_insert(inner* x, int pos, node* child, size_type count);
+    static void inner_erase(inner* x, int pos);
+
+    template< class U > void insert_at(size_type pos, U&& value);
+    template< class U > static node* insert_into(node* x, size_type pos, U&& value);
+    void erase_at(size_type pos);
+    static void erase_from(node* x, size_type pos);
+    static void rebalance(inner* x, int i);
+
+    node* m_root;
+    size_type m_size;
+};
+
+
+template< class T, std::size_t NodeBytes >
+template< bool Const >
+class order_statistic_tree<T, NodeBytes>::basic_iterator {
+    typedef typename std::conditional<Const, const order_statistic_tree, order_statistic_tree>::type tree_type;
+
+public:
+    typedef std::random_access_iterator_tag                         iterator_category;
+    typedef T                                                       value_type;
+    typedef std::ptrdiff_t                                          difference_type;
+    typedef typename std::conditional<Const, const T*, T*>::type    pointer;
+    typedef typename std::conditional<Const, const T&, T&>::type    reference;
+
+    basic_iterator() : m_tree(nullptr), m_pos(0) {}
+    basic_iterator(tree_type* tree, difference_type pos) : m_tree(tree), m_pos(pos) {}
+    // iterator -> const_iterator
+    basic_iterator(const basic_iterator<false>& other) : m_tree(other.m_tree), m_pos(other.m_pos) {}
+
+    reference operator*() const { return m_tree->element(size_type(m_pos)); }
+    pointer operator->() const { return &operator*(); }
+    reference operator[](difference_type i) const { return m_tree->element(size_type(m_pos + i)); }
+
+    basic_iterator& operator++() { ++m_pos; return *this; }
+    basic_iterator operator++(int) { basic_iterator tmp(*this); ++m_pos; return tmp; }
+    basic_iterator& operator--() { --m_pos; return *this; }
+    basic_iterator operator--(int) { basic_iterator tmp(*this); --m_pos; return tmp; }
+    basic_iterator& operator+=(difference_type i) { m_pos += i; return *this; }
+    basic_iterator& operator-=(difference_type i) { m_pos -= i; return *this; }
+    basic_iterator operator+(difference_type i) const { return basic_iterator(m_tree, m_pos + i); }
+    basic_iterator operator-(difference_type i) const { return basic_iterator(m_tree, m_pos - i); }
+    friend basic_iterator operator+(difference_type i, const basic_iterator& it) { return it + i; }
+    difference_type operator-(const basic_iterator& other) const { return m_pos - other.m_pos; }
+
+    bool operator==(const basic_iterator& other) const { return m_pos == other.m_pos; }
+    bool operator!=(const basic_iterator& other) const { return m_pos != other.m_pos; }
+    bool operator<(const basic_iterator& other) const { return m_pos < other.m_pos; }
+    bool operator>(const basic_iterator& other) const { return m_pos > other.m_pos; }
+    bool operator<=(const basic_iterator& other) const { return m_pos <= other.m_pos; }
+    bool operator>=(const basic_iterator& other) const { return m_pos >= other.m_pos; }
+
+private:
+    friend class order_statistic_tree;
+    template< bool > friend class basic_iterator;
+
+    tree_type* m_tree;
+    difference_type m_pos;
+};
+
+
+// implementation
+// ----------------------------------------------------------------------------
+
+template< class T, std::size_t NodeBytes >
+template< class InputIterator >
+void order_statistic_tree<T, NodeBytes>::assign(InputIterator first, InputIterator last)
+{
+    std::vector<T> items(first, last);
+    clear();
+    if( items.empty() )
+        return;
+
+    // spread the elements evenly, so every node is at least half full
+    const size_type n = items.size();
+    const size_type leaves = (n + leaf_capacity - 1) / leaf_capacity;
+    std::vector<node*> level;
+    std::vector<size_type> counts;
+    level.reserve(leaves);
+    counts.reserve(leaves);
+    size_type next = 0;
+    for( size_type i = 0; i < leaves; ++i ) {
+        const size_type count = n / leaves + (i < n % leaves ? 1 : 0);
+        leaf* l = new leaf;
+        for( ; size_type(l->n) < count; ++l->n )
+            new (&l->item(l->n)) T(std::move(items[next++]));
+        level.push_back(l);
+        counts.push_back(count);
+    }
+
+    while( level.size() > 1 ) {
+        const size_type k = level.size();
+        const size_type parents = (k + inner_capacity - 1) / inner_capacity;
+        std::vector<node*> parentLevel;
+        std::vector<size_type> parentCounts;
+        parentLevel.reserve(parents);
+        parentCounts.reserve(parents);
+        size_type child = 0;
+        for( size_type i = 0; i < parents; ++i ) {
+            const size_type children = k / parents + (i < k % parents ? 1 : 0);
+            inner* x = new inner;
+            size_type total = 0;
+            for( ; size_type(x->n) < children; ++x->n, ++child ) {
+                x->children[x->n] = level[child];
+                x->counts[x->n] = counts[child];
+                total += counts[child];
+            }
+            parentLevel.push_back(x);
+            parentCounts.push_back(total);
+        }
+        level.swap(parentLevel);
+        counts.swap(parentCounts);
+    }
+
+    m_root = level.front();
+    m_size = n;
+}
+
+template< class T, std::size_t NodeBytes >
+std::vector<T> order_statistic_tree<T, NodeBytes>::take_all()
+{
+    std::vector<T> items;
+    items.reserve(m_size);
+
+    // depth first walk over the leaves, left to right
+    std::vector<node*> stack;
+    if( m_root )
+        stack.push_back(m_root);
+    while( ! stack.empty() ) {
+        node* x = stack.back();
+        stack.pop_back();
+        if( x->is_leaf ) {
+            leaf* l = static_cast<leaf*>(x);
+            for( int i = 0; i < l->n; ++i )
+                items.push_back(std::move(l->item(i)));
+        } else {
+            inner* in = static_cast<inner*>(x);
+            for( int i = in->n - 1; i >= 0; --i )
+                stack.push_back(in->children[i]);
+        }
+    }
+
+    clear();
+    return items;
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::clear()
+{
+    if( m_root )
+        destroy(m_root);
+    m_root = nullptr;
+    m_size = 0;
+}
+
+template< class T, std::size_t NodeBytes >
+typename order_statistic_tree<T, NodeBytes>::size_type
+order_statistic_tree<T, NodeBytes>::count_of(node* x)
+{
+    if( x->is_leaf )
+        return size_type(x->n);
+
+    const inner* in = static_cast<const inner*>(x);
+    size_type count = 0;
+    for( int i = 0; i < in->n; ++i )
+        count += in->counts[i];
+    return count;
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::destroy(node* x)
+{
+    if( x->is_leaf ) {
+        delete static_cast<leaf*>(x);
+        return;
+    }
+
+    inner* in = static_cast<inner*>(x);
+    for( int i = 0; i < in->n; ++i )
+        destroy(in->children[i]);
+    delete in;
+}
+
+template< class T, std::size_t NodeBytes >
+typename order_statistic_tree<T, NodeBytes>::node*
+order_statistic_tree<T, NodeBytes>::clone(node* x)
+{
+    if( x->is_leaf ) {
+        leaf* src = static_cast<leaf*>(x);
+        leaf* l = new leaf;
+        for( ; l->n < src->n; ++l->n )
+            new (&l->item(l->n)) T(src->item(l->n));
+        return l;
+    }
+
+    inner* src = static_cast<inner*>(x);
+    inner* in = new inner;
+    for( ; in->n < src->n; ++in->n ) {
+        in->children[in->n] = clone(src->children[in->n]);
+        in->counts[in->n] = src->counts[in->n];
+    }
+    return in;
+}
+
+template< class T, std::size_t NodeBytes >
+T& order_statistic_tree<T, NodeBytes>::element(size_type i) const
+{
+    assert(i < m_size);
+
+    node* x = m_root;
+    while( ! x->is_leaf ) {
+        const inner* in = static_cast<const inner*>(x);
+        int c = 0;
+        while( i >= in->counts[c] ) {
+            i -= in->counts[c];
+            ++c;
+        }
+        x = in->children[c];
+    }
+    return static_cast<leaf*>(x)->item(int(i));
+}
+
+template< class T, std::size_t NodeBytes >
+template< class U >
+void order_statistic_tree<T, NodeBytes>::leaf_insert(leaf* l, int pos, U&& value)
+{
+    assert(l->n < leaf_capacity);
+
+    if( pos == l->n ) {
+        new (&l->item(pos)) T(std::forward<U>(value));
+    } else {
+        new (&l->item(l->n)) T(std::move(l->item(l->n - 1)));
+        for( int i = l->n - 1; i > pos; --i )
+            l->item(i) = std::move(l->item(i - 1));
+        l->item(pos) = std::forward<U>(value);
+    }
+    ++l->n;
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::leaf_erase(leaf* l, int pos)
+{
+    for( int i = pos; i < l->n - 1; ++i )
+        l->item(i) = std::move(l->item(i + 1));
+    --l->n;
+    l->item(l->n).~T();
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::inner_insert(inner* x, int pos, node* child, size_type count)
+{
+    assert(x->n < inner_capacity);
+
+    for( int i = x->n; i > pos; --i ) {
+        x->children[i] = x->children[i - 1];
+        x->counts[i] = x->counts[i - 1];
+    }
+    x->children[pos] = child;
+    x->counts[pos] = count;
+    ++x->n;
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::inner_erase(inner* x, int pos)
+{
+    for( int i = pos; i < x->n - 1; ++i ) {
+        x->children[i] = x->children[i + 1];
+        x->counts[i] = x->counts[i + 1];
+    }
+    --x->n;
+}
+
+template< class T, std::size_t NodeBytes >
+template< class U >
+void order_statistic_tree<T, NodeBytes>::insert_at(size_type pos, U&& value)
+{
+    assert(pos <= m_size);
+
+    if( ! m_root )
+        m_root = new leaf;
+
+    node* split = insert_into(m_root, pos, std::forward<U>(value));
+    ++m_size;
+
+    if( split ) {
+        const size_type splitCount = count_of(split);
+        inner* root = new inner;
+        inner_insert(root, 0, m_root, m_size - splitCount);
+        inner_insert(root, 1, split, splitCount);
+        m_root = root;
+    }
+}
+
+// Inserts value at pos into the subtree x. A full node is split in halves first, the
+// new right half is returned for the caller to add to the parent.
+template< class T, std::size_t NodeBytes >
+template< class U >
+typename order_statistic_tree<T, NodeBytes>::node*
+order_statistic_tree<T, NodeBytes>::insert_into(node* x, size_type pos, U&& value)
+{
+    if( x->is_leaf ) {
+        leaf* l = static_cast<leaf*>(x);
+        leaf* target = l;
+        leaf* right = nullptr;
+        if( l->n == leaf_capacity ) {
+            right = new leaf;
+            const int half = leaf_capacity / 2;
+            for( int i = half; i < l->n; ++i, ++right->n ) {
+                new (&right->item(right->n)) T(std::move(l->item(i)));
+                l->item(i).~T();
+            }
+            l->n = half;
+            if( pos > size_type(half) ) {
+                target = right;
+                pos -= half;
+            }
+        }
+        leaf_insert(target, int(pos), std::forward<U>(value));
+        return right;
+    }
+
+    inner* in = static_cast<inner*>(x);
+    int c = 0;
+    while( c < in->n - 1 && pos > in->counts[c] ) {
+        pos -= in->counts[c];
+        ++c;
+    }
+
+    node* split = insert_into(in->children[c], pos, std::forward<U>(value));
+    ++in->counts[c];
+    if( ! split )
+        return nullptr;
+
+    const size_type splitCount = count_of(split);
+    in->counts[c] -= splitCount;
+
+    inner* target = in;
+    inner* right = nullptr;
+    int at = c + 1;
+    if( in->n == inner_capacity ) {
+        right = new inner;
+        const int half = inner_capacity / 2;
+        for( int i = half; i < in->n; ++i, ++right->n ) {
+            right->children[right->n] = in->children[i];
+            right->counts[right->n] = in->counts[i];
+        }
+        in->n = half;
+        if( at > half ) {
+            target = right;
+            at -= half;
+        }
+    }
+    inner_insert(target, at, split, splitCount);
+    return right;
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::erase_at(size_type pos)
+{
+    assert(pos < m_size);
+
+    erase_from(m_root, pos);
+    --m_size;
+
+    while( ! m_root->is_leaf && m_root->n == 1 ) {
+        inner* old = static_cast<inner*>(m_root);
+        m_root = old->children[0];
+        delete old;
+    }
+    if( m_size == 0 )
+        clear();
+}
+
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::erase_from(node* x, size_type pos)
+{
+    if( x->is_leaf ) {
+        leaf_erase(static_cast<leaf*>(x), int(pos));
+        return;
+    }
+
+    inner* in = static_cast<inner*>(x);
+    int c = 0;
+    while( pos >= in->counts[c] ) {
+        pos -= in->counts[c];
+        ++c;
+    }
+
+    erase_from(in->children[c], pos);
+    --in->counts[c];
+    rebalance(in, c);
+}
+
+// Keeps child i of x at least half full, by merging it with a sibling if both fit into
+// one node, or else by moving elements over from the sibling.
+template< class T, std::size_t NodeBytes >
+void order_statistic_tree<T, NodeBytes>::rebalance(inner* x, int i)
+{
+    node* child = x->children[i];
+    if( child->n >= capacity(child) / 2 || x->n < 2 )
+        return;
+
+    const int li = i > 0 ? i - 1 : i;
+    node* left = x->children[li];
+    node* right = x->children[li + 1];
+    const int total = left->n + right->n;
+
+    if( left->is_leaf ) {
+        leaf* l = static_cast<leaf*>(left);
+        leaf* r = static_cast<leaf*>(right);
+
+        if( total <= leaf_capacity ) {
+            for( int j = 0; j < r->n; ++j )
+                leaf_insert(l, l->n, std::move(r->item(j)));
+            x->counts[li] += x->counts[li + 1];
+            delete r;
+            inner_erase(x, li + 1);
+            return;
+        }
+
+        const int leftTarget = total / 2;
+        while( l->n < leftTarget ) {
+            leaf_insert(l, l->n, std::move(r->item(0)));
+            leaf_erase(r, 0);
+        }
+        while( l->n > leftTarget ) {
+            leaf_insert(r, 0, std::move(l->item(l->n - 1)));
+            leaf_erase(l, l->n - 1);
+        }
+        x->counts[li] = size_type(l->n);
+        x->counts[li + 1] = size_type(r->n);
+        return;
+    }
+
+    inner* l = static_cast<inner*>(left);
+    inner* r = static_cast<inner*>(right);
+
+    if( total <= inner_capacity ) {
+        for( int j = 0; j < r->n; ++j )
+            inner_insert(l, l->n, r->children[j], r->counts[j]);
+        x->counts[li] += x->counts[li + 1];
+        delete r;
+        inner_erase(x, li + 1);
+        return;
+    }
+
+    const int leftTarget = total / 2;
+    while( l->n < leftTarget ) {
+        x->counts[li] += r->counts[0];
+        x->counts[li + 1] -= r->counts[0];
+        inner_insert(l, l->n, r->children[0], r->counts[0]);
+        inner_erase(r, 0);
+    }
+    while( l->n > leftTarget ) {
+        const int last = l->n - 1;
+        x->counts[li] -= l->counts[last];
+        x->counts[li + 1] += l->counts[last];
+        inner_insert(r, 0, l->children[last], l->counts[last]);
+        inner_erase(l, last);
+    }
+}
+
+
+// container hooks of adaptor
+// ----------------------------------------------------------------------------
+
+template< class SortAlgorithm, class T, std::size_t NodeBytes, class Compare >
+void sort_container(order_statistic_tree<T, NodeBytes>& c, const Compare& compare)
+{
+    // sort a flat copy instead of dereferencing tree iterators, then rebuild in O(n)
+    std::vector<T> items = c.take_all();
+    SortAlgorithm::template sort(items.begin(), items.end(), compare);
+    c.assign(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+}
+
+template< class T, std::size_t NodeBytes, class Iterator, class Compare >
+void merge_sorted(order_statistic_tree<T, NodeBytes>& c, Iterator first, Iterator last, const Compare& compare)
+{
+    typedef typename order_statistic_tree<T, NodeBytes>::difference_type index;
+
+    const std::size_t m = std::size_t(std::distance(first, last));
+    if( m * 16 < c.size() ) {
+        // few values: insert each in O(log n), searching from the previous one on
+        index pos = 0;
+        for( ; first != last; ++first ) {
+            pos = std::upper_bound(c.cbegin() + pos, c.cend(), *first, compare) - c.cbegin();
+            c.insert(c.cbegin() + pos, *first);
+            ++pos;
+        }
+    } else {
+        // merge flat copies, then rebuild in O(n)
+        std::vector<T> items = c.take_all();
+        std::vector<T> merged;
+        merged.reserve(items.size() + m);
+        std::merge(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()),
+                   first, last, std::back_inserter(merged), compare);
+        c.assign(std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()));
+    }
+}
+
+template< class T, std::size_t NodeBytes, class Predicate >
+std::ptrdiff_t remove_from_container(order_statistic_tree<T, NodeBytes>& c, Predicate remove)
+{
+    // compact a flat copy, then rebuild in O(n)
+    std::vector<T> items = c.take_all();
+    const std::ptrdiff_t n = std::ptrdiff_t(items.size());
+    std::ptrdiff_t kept = 0;
+    for( std::ptrdiff_t i = 0; i < n; ++i ) {
+        if( remove(i, static_cast<const T&>(items[i])) )
+            continue;
+        if( kept != i )
+            items[kept] = std::move(items[i]);
+        ++kept;
+    }
+    c.assign(std::make_move_iterator(items.begin()), std::make_move_iterator(items.begin() + kept));
+    return n - kept;
+}
+
+template< class T, std::size_t NodeBytes, class U >
+void move_and_assign(order_statistic_tree<T, NodeBytes>& c, std::ptrdiff_t from, std::ptrdiff_t to, U&& value)
+{
+    c.erase(c.cbegin() + from);
+    c.insert(c.cbegin() + to, T(std::forward<U>(value)));
+}
+
+
+} // namespace sorted_sequence
+
+#endif // SORTED_SEQUENCE_ORDER_STATISTIC_TREE_H
@@ -19,8 +19,17 @@
 #define SORTED_SEQUENCE_H
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <numeric>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <cassert>
@@ -79,6 +88,189 @@ struct default_sort_algorithm {
     }
 };
 
+/**
+ * Stable merge sort on up to std::thread::hardware_concurrency() threads: ranges longer
+ * than GrainSize are split in halves, sorted concurrently and merged in place. Ranges up
+ * to GrainSize are left to std::stable_sort, as threads do not pay off for them.
+ * compare gets called concurrently, so it must not modify any shared state.
+ */
+template< std::size_t GrainSize = 16384 >
+struct parallel_stable_sort_algorithm {
+    template<class RAIterator, class Compare>
+    static void sort(RAIterator begin, RAIterator end, Compare compare)
+    {
+        const unsigned threads = std::thread::hardware_concurrency();
+        sort_range(begin, end, compare, threads > 0 ? threads : 1);
+    }
+
+private:
+    template<class RAIterator, class Compare>
+    static void sort_range(RAIterator begin, RAIterator end, const Compare& compare, unsigned threads)
+    {
+        const auto n = end - begin;
+        if( threads < 2 || std::size_t(n) <= GrainSize ) {
+            std::stable_sort(begin, end, compare);
+            return;
+        }
+
+        const RAIterator middle = begin + n / 2;
+        std::exception_ptr error;
+        std::thread left;
+        try {
+            left = std::thread([begin, middle, &compare, threads, &error] {
+                try {
+                    sort_range(begin, middle, compare, threads / 2);
+                } catch( ... ) {
+                    error = std::current_exception();
+                }
+            });
+        } catch( const std::system_error& ) { // out of threads
+            std::stable_sort(begin, end, compare);
+            return;
+        }
+
+        try {
+            sort_range(middle, end, compare, threads - threads / 2);
+        } catch( ... ) {
+            left.join();
+            throw;
+        }
+        left.join();
+        if( error )
+            std::rethrow_exception(error);
+
+        std::inplace_merge(begin, middle, end, compare);
+    }
+};
+
+/// A number unique to each modification of any adaptor, see adaptor::modificationStamp.
+inline std::uint64_t next_modification_stamp()
+{
+    static std::atomic<std::uint64_t> stamp(0);
+    return ++stamp;
+}
+
+/// Tag for constructing an adaptor from a container that is already sorted.
+struct presorted_t {};
+static const presorted_t presorted = presorted_t();
+
+
+// container hooks
+// ----------------------------------------------------------------------------
+
+// The generic versions work on any random access container. Node based containers
+// overload them (found by argument dependent lookup), see order_statistic_tree.h.
+
+template< class SortAlgorithm, class Container, class Compare >
+void sort_container(Container& c, const Compare& compare)
+{
+    SortAlgorithm::template sort(c.begin(), c.end(), compare);
+}
+
+/// Moves the element at from to position to (shifting the ones in between) and assigns value to it.
+template< class Container, class T >
+void move_and_assign(Container& c, std::ptrdiff_t from, std::ptrdiff_t to, T&& value)
+{
+    auto first = c.begin();
+    if( to < from )
+        std::move_backward(first + to, first + from, first + from + 1);
+    else
+        std::move(first + from + 1, first + to + 1, first + from);
+    c[to] = std::forward<T>(value);
+}
+
+
+/**
+ * Merges the sorted values [first, last) into the sorted c with one linear pass, placing
+ * them after equal values of c. Uses a buffer for the merge if memory is available.
+ */
+template< class Container, class Iterator, class Compare >
+void merge_sorted(Container& c, Iterator first, Iterator last, const Compare& compare)
+{
+    const auto n = c.size();
+    c.reserve(n + std::distance(first, last));
+    for( ; first != last; ++first )
+        c.push_back(*first); // Qt container do not support range insert
+    std::inplace_merge(c.begin(), c.begin() + n, c.end(), compare);
+}
+
+
+/**
+ * Removes the elements remove(index, value) is true for with one pass over c, moving the
+ * kept ones forward, and returns their number. remove is called once per element in order.
+ */
+template< class Container, class Predicate >
+std::ptrdiff_t remove_from_container(Container& c, Predicate remove)
+{
+    const std::ptrdiff_t n = std::ptrdiff_t(c.size());
+    std::ptrdiff_t kept = 0;
+    auto first = c.begin();
+    for( std::ptrdiff_t i = 0; i < n; ++i ) {
+        if( remove(i, static_cast<const typename Container::value_type&>(first[i])) )
+            continue;
+        if( kept != i )
+            first[kept] = std::move(first[i]);
+        ++kept;
+    }
+    c.erase(c.begin() + kept, c.end());
+    return n - kept;
+}
+
+
+/**
+ * Sorts c with compare like sort_container, but also reports for each key in oldToNew
+ * its new position after sorting (as the value), see adaptor::setCompareOperatorGetReorderMap.
+ */
+template< class SortAlgorithm, class Container, class Compare, class Map >
+void sort_get_reorder_map(Container& c, const Compare& compare, Map* oldToNew)
+{
+    typedef typename Container::difference_type index;
+
+    const index n = index(c.size());
+
+    std::vector<index> reorderList(n);
+    std::iota(reorderList.begin(), reorderList.end(), 0);
+
+    { // sort reorderList as if it were the actual container
+        const auto f = [&c, &compare] (index lhs, index rhs) { return compare(c[lhs], c[rhs]); };
+        SortAlgorithm::template sort(reorderList.begin(), reorderList.end(), f);
+    }
+
+    { // fill out oldToNew with reorderList
+        const auto mapEnd = oldToNew->end();
+        index mapLeft = oldToNew->size();
+        for( index i = 0; i < n && mapLeft > 0; ++i ) {
+            auto it = oldToNew->find(reorderList.at(i));
+            if( it != mapEnd ) {
+                value_ref(it) = i;
+                --mapLeft;
+            }
+        }
+    }
+
+    // sort actual container with reorderList (= permutation)
+    for( index i = 0; i < n; ++i ) {
+        index j = reorderList.at(i);
+
+        if( i == j || j < 0 ) // trivial permutation cycle or already processed
+            continue;
+
+        // shift all values according to the permutation cycle containing position i
+
+        auto tmp = std::move(c[i]);
+
+        index k = i;
+        do {
+            c[k] = std::move(c[j]);
+            k = j;
+            j = reorderList.at(j);
+            reorderList[k] = -1; // mark as processed
+        } while( j != i );
+
+        c[k] = std::move(tmp);
+    }
+}
+
 
 // default (std::less wrapper) + function wrapper Compare
 // ----------------------------------------------------------------------------
@@ -98,7 +290,109 @@ bool operator!=(const default_compare<T>&, const default_compare<T>&)
     return false;
 }
 
+/// Whether two comparisons order alike; ones without operator== (e.g. lambdas) are taken to.
+template< class Compare >
+auto same_compare(const Compare& lhs, const Compare& rhs, int) -> decltype(bool(lhs == rhs))
+{
+    return lhs == rhs;
+}
 
+template< class Compare >
+bool same_compare(const Compare&, const Compare&, long)
+{
+    return true;
+}
+
+
+// matching runs of equivalent elements
+// ----------------------------------------------------------------------------
+
+/**
+ * Hash of an element agreeing with its operator==, for matching long runs of equivalent
+ * elements in the multiset algebra of adaptor in expected linear time. Element types
+ * without std::hash can overload it (found by argument dependent lookup); runs of elements
+ * without any are matched pairwise, in time quadratic in their length.
+ */
+template< class T >
+auto element_hash(const T& value) -> decltype(std::size_t(std::hash<T>()(value)))
+{
+    return std::hash<T>()(value);
+}
+
+template< class T >
+auto has_element_hash(const T* value, int) -> decltype(element_hash(*value), std::true_type());
+
+template< class T >
+std::false_type has_element_hash(const T*, long);
+
+// Matches each of the equivalent elements [a, aEnd) to the first unmatched equal one of
+// bRun, calling both(i, value) or onlyThis(i, value) for it, pairwise.
+template< class Iterator, class OtherIterator, class OnlyThis, class Both >
+void match_run(Iterator a, Iterator aEnd, std::ptrdiff_t i, const std::vector<OtherIterator>& bRun,
+               std::vector<bool>& matched, OnlyThis& onlyThis, Both& both, std::false_type)
+{
+    const std::size_t n = bRun.size();
+    // unmatched[k] leads to the first unmatched position from k on, skipping the matched ones
+    std::vector<std::size_t> unmatched(n + 1);
+    std::iota(unmatched.begin(), unmatched.end(), std::size_t(0));
+    const auto firstUnmatched = [&unmatched] (std::size_t k) {
+        while( unmatched[k] != k ) {
+            unmatched[k] = unmatched[unmatched[k]];
+            k = unmatched[k];
+        }
+        return k;
+    };
+
+    for( ; a != aEnd; ++a, ++i ) {
+        std::size_t k = firstUnmatched(0);
+        while( k < n && ! (*a == *bRun[k]) )
+            k = firstUnmatched(k + 1);
+        if( k < n ) {
+            matched[k] = true;
+            unmatched[k] = k + 1;
+            both(i, *a);
+        } else {
+            onlyThis(i, *a);
+        }
+    }
+}
+
+// the same through a hash table of bRun
+template< class Iterator, class OtherIterator, class OnlyThis, class Both >
+void match_run(Iterator a, Iterator aEnd, std::ptrdiff_t i, const std::vector<OtherIterator>& bRun,
+               std::vector<bool>& matched, OnlyThis& onlyThis, Both& both, std::true_type)
+{
+    // positions by hash, the first one last
+    std::unordered_map< std::size_t, std::vector<std::size_t> > positions;
+    positions.reserve(bRun.size());
+    for( std::size_t k = bRun.size(); k-- > 0; )
+        positions[element_hash(*bRun[k])].push_back(k);
+
+    for( ; a != aEnd; ++a, ++i ) {
+        const auto it = positions.find(element_hash(*a));
+        std::size_t p = 0;
+        if( it != positions.end() ) {
+            std::vector<std::size_t>& ks = it->second;
+            while( ! ks.empty() && matched[ks.back()] )
+                ks.pop_back();
+            for( p = ks.size(); p > 0 && (matched[ks[p - 1]] || ! (*a == *bRun[ks[p - 1]])); --p )
+                ;
+            if( p > 0 )
+                matched[ks[p - 1]] = true;
+        }
+        if( p > 0 )
+            both(i, *a);
+        else
+            onlyThis(i, *a);
+    }
+}
+
+
+/**
+ * Type erased comparison, convenient where the order is only known at runtime. Every
+ * comparison is an indirect call though; in hot sort and search loops prefer a
+ * concrete functor type as the adaptor's Compare, which the algorithms can inline.
+ */
 template< typename T >
 class function_compare {
 public:
@@ -154,10 +448,13 @@ public:
     typedef const_iterator                          ConstIterator;
     typedef Container                               container_type;
     typedef Compare                                 compare_type;
+    typedef std::vector< std::pair<index, index> >  index_ranges; // ascending [first, last) pairs
 
     adaptor() = default;
     explicit adaptor(const Container& container, const Compare& compare = {});
     explicit adaptor(Container&& container, const Compare& compare = {});
+    /// Takes over container without sorting it, it must be sorted by compare already.
+    adaptor(presorted_t, Container&& container, const Compare& compare = {});
     explicit adaptor(const Compare& compare);
 
     // + default copy/move ctor/assignment
@@ -179,6 +476,10 @@ public:
     void setCompareOperatorGetReorderMap(const Compare& comparison,
                                          Map* oldToNew);
 
+    /**
+     * Position value would be inserted at. A valid positionHint is taken as a guess, the
+     * search then gallops outwards from it, taking O(log distance) comparisons.
+     */
     template< class T >
     index insertPosition(const T& value, InsertMode mode = InsertLast,
                          index positionHint = -1) const;
@@ -186,6 +487,17 @@ public:
     index insert(T&& value, InsertMode mode = InsertLast,
                  index positionHint = -1);
 
+    /**
+     * Inserts the values [first, last) like insert with InsertLast, but sorts them once and
+     * merges them in with a single pass over the container.
+     * @return The ranges of positions the inserted values occupy afterwards
+     */
+    template< class InputIterator >
+    index_ranges insertRange(InputIterator first, InputIterator last);
+    /// The ranges insertRange would report for the values [first, last), which must be sorted.
+    template< class ForwardIterator >
+    index_ranges insertedRanges(ForwardIterator first, ForwardIterator last) const;
+
     /**
      * @brief Change the value at index i to newValue.
      * @param i Index of the value to change
@@ -193,7 +505,8 @@ public:
      * @param newPositionHintBeforeRemove Conceptually the new value gets inserted and then
      *                                    the old value gets removed, so this hint should be
      *                                    equal to insertPosition(newValue, mode) to prevent
-     *                                    one binary search operation.
+     *                                    one binary search operation. Without it, the
+     *                                    search gallops outwards from i.
      * @return The new position after changing the value
      */
     template< class T >
@@ -202,6 +515,8 @@ public:
 
     const Container& container() const { return d.c; }
     Container takeContainer();
+    /// Changes whenever the elements or their order change, e.g. to keep indexes in sync.
+    std::uint64_t modificationStamp() const { return d.stamp; }
 
     const value_type& at(index i) const { return d.c.at(i); }
     const value_type& front() const { return d.c.front(); }
@@ -230,17 +545,21 @@ public:
     template< class T > index findLast(const T& value) const;
     template< class T > std::pair<index, index> range(const T& value) const;
 
-    void clear() { d.c.clear(); }
-    void removeAt(index i) { d.c.erase(d.c.begin() + i); }
+    void clear() { edit().clear(); }
+    void removeAt(index i) { Container& c = edit(); c.erase(c.begin() + i); }
     void removeFirst() { removeAt(0); }
     void removeLast() { removeAt(size() - 1); }
     void removeRange(index begin, index end);
     template< class T > bool removeOne(const T& value);
     template< class T > index removeAll(const T& value);
+    /// Removes the values pred is true for in a single pass, returning their number.
+    template< class Predicate > index removeIf(Predicate pred);
+    /// Removes the values in the ascending [first, last) ranges in a single pass, see index_ranges.
+    void removeRanges(const index_ranges& ranges);
 
     const_iterator erase(const_iterator position);
     const_iterator erase(const_iterator first, const_iterator last);
-    void pop_back() { d.c.pop_back(); }
+    void pop_back() { edit().pop_back(); }
 
     value_type takeAt(index i);
     value_type takeFirst() { return takeAt(0); }
@@ -263,23 +582,61 @@ public:
     static adaptor<Container, Compare, SortAlgorithm> merge(const adaptor<OtherContainer1, Compare, OtherSortAlgorithm1>& l1,
                                                             const adaptor<OtherContainer2, Compare, OtherSortAlgorithm2>& l2);
 
+    /**
+     * Multiset algebra with other, in a single pass over both. Elements match if they are
+     * equivalent and equal (like for indexOf), each one matching at most one of the other.
+     * Long runs of equivalent elements take expected linear time if the elements have an
+     * element_hash, else time quadratic in the run length.
+     * Both must be sorted by the same comparison, else the result is empty like for merge.
+     */
+    template< class OtherContainer, class OtherSortAlgorithm >
+    adaptor<Container, Compare, SortAlgorithm> mergeWith(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const;
+    template< class OtherContainer, class OtherSortAlgorithm >
+    adaptor<Container, Compare, SortAlgorithm> intersect(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const;
+    template< class OtherContainer, class OtherSortAlgorithm >
+    adaptor<Container, Compare, SortAlgorithm> difference(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const;
+    template< class OtherContainer, class OtherSortAlgorithm >
+    adaptor<Container, Compare, SortAlgorithm> symmetricDifference(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const;
+    /// The positions of the elements difference would keep, e.g. the ones to remove to get to other.
+    template< class OtherContainer, class OtherSortAlgorithm >
+    index_ranges differenceRanges(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const;
+
 private:
+    template< class, class, class > friend class adaptor;
+
+    // calls onlyThis(i, value), onlyOther(j, value) and both(i, value) in order, see mergeWith
+    template< class OtherContainer, class OtherSortAlgorithm, class OnlyThis, class OnlyOther, class Both >
+    void matchWith(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other,
+                   OnlyThis onlyThis, OnlyOther onlyOther, Both both) const;
+
     void sort()
     {
-        SortAlgorithm::template sort(d.c.begin(), d.c.end(), d);
+        sort_container<SortAlgorithm>(edit(), d.compare());
+    }
+
+    // the container for modifying it
+    Container& edit()
+    {
+        d.stamp = next_modification_stamp();
+        return d.c;
     }
 
     struct Data : public Compare {
         // use inheritance of Compare (instead of a data member) to allow for the
         // empty base class optimization
         Data(const Compare& comp = Compare(), const Container& cntr = Container())
-            : Compare(comp), c(cntr)
+            : Compare(comp), c(cntr), stamp(next_modification_stamp())
         {}
         Data(const Compare& comp, Container&& cntr)
-            : Compare(comp), c(std::move(cntr))
+            : Compare(comp), c(std::move(cntr)), stamp(next_modification_stamp())
         {}
 
+        // pass this to algorithms taking the comparison by value, not Data itself,
+        // which would copy the container along
+        const Compare& compare() const { return *this; }
+
         Container c;
+        std::uint64_t stamp;
     };
 
     Data d;
@@ -305,6 +662,15 @@ adaptor<Container, Compare, SortAlgorithm>::adaptor(Container&& container,
     sort();
 }
 
+template<class Container, class Compare, class SortAlgorithm>
+adaptor<Container, Compare, SortAlgorithm>::adaptor(presorted_t,
+                                                    Container&& container,
+                                                    const Compare& compare)
+    : d(compare, std::move(container))
+{
+    assert(std::is_sorted(d.c.begin(), d.c.end(), d.compare()));
+}
+
 template<class Container, class Compare, class SortAlgorithm>
 adaptor<Container, Compare, SortAlgorithm>::adaptor(const Compare& compare)
     : d(compare)
@@ -341,50 +707,7 @@ void adaptor<Container, Compare, SortAlgorithm>::setCompareOperatorGetReorderMap
     }
 
     static_cast<Compare&>(d) = comparison;
-
-    const index n = index(size());
-
-    std::vector<index> reorderList(n);
-    std::iota(reorderList.begin(), reorderList.end(), 0);
-
-    { // sort reorderList as if it were the actual container
-        const auto f = [this] (index lhs, index rhs) { return d(at(lhs), at(rhs)); };
-        SortAlgorithm::template sort(reorderList.begin(), reorderList.end(), f);
-    }
-
-    { // fill out oldToNew with reorderList
-        const auto mapEnd = oldToNew->end();
-        index mapLeft = oldToNew->size();
-        for( index i = 0; i < n && mapLeft > 0; ++i ) {
-            auto it = oldToNew->find(reorderList.at(i));
-            if( it != mapEnd ) {
-                value_ref(it) = i;
-                --mapLeft;
-            }
-        }
-    }
-
-    // sort actual container with reorderList (= permutation)
-    for( index i = 0; i < n; ++i ) {
-        index j = reorderList.at(i);
-
-        if( i == j || j < 0 ) // trivial permutation cycle or already processed
-            continue;
-
-        // shift all values according to the permutation cycle containing position i
-
-        value_type tmp = std::move(d.c[i]);
-
-        index k = i;
-        do {
-            d.c[k] = std::move(d.c[j]);
-            k = j;
-            j = reorderList.at(j);
-            reorderList[k] = -1; // mark as processed
-        } while( j != i );
-
-        d.c[k] = std::move(tmp);
-    }
+    sort_get_reorder_map<SortAlgorithm>(edit(), d.compare(), oldToNew);
 }
 
 
@@ -396,39 +719,58 @@ adaptor<Container, Compare, SortAlgorithm>::insertPosition(const T& value,
                                                            index positionHint) const
 {
     const index n = index(size());
-    if( positionHint >= 0 && positionHint <= n ) {
-        if( n == 0 )
-            return 0;
-
-        if( positionHint == 0 ) {
-            if( mode == InsertFirst && ! d(first(), value) )
-                return positionHint;
-            else if( mode == InsertLast && d(value, first()) )
-                return positionHint;
-        }  else if( positionHint == n ) {
-            if( mode == InsertFirst && d(last(), value) )
-                return positionHint;
-            else if( mode == InsertLast && ! d(value, last()))
-                return positionHint;
-        } else {
-            if( mode == InsertFirst && d(at(positionHint - 1), value) ) {
-                if( ! d(at(positionHint), value) )
-                    return positionHint;
-                else
-                    return offset(std::lower_bound(begin() + positionHint, end(), value, d));
-            } else if( mode == InsertLast && d(value, at(positionHint))) {
-                if( ! d(value, at(positionHint - 1)) )
-                    return positionHint;
-                else
-                    return offset(std::upper_bound(begin(), begin() + positionHint, value, d));
+    if( positionHint < 0 || positionHint > n ) {
+        if( mode == InsertFirst )
+            return offset(std::lower_bound(begin(), end(), value, d.compare()));
+        else
+            return offset(std::upper_bound(begin(), end(), value, d.compare()));
+    }
+
+    // whether value goes behind the element at i
+    const auto behind = [this, &value, mode] (index i) {
+        return mode == InsertFirst ? d(at(i), value) : ! d(value, at(i));
+    };
+
+    // gallop from the hint towards the position with doubling steps until it is bracketed
+    // by [lo, hi], so the search takes O(log distance) instead of O(log n) comparisons
+    index lo;
+    index hi;
+    if( positionHint > 0 && ! behind(positionHint - 1) ) {
+        hi = positionHint - 1;
+        for( index step = 1; ; step *= 2 ) {
+            const index probe = hi - step;
+            if( probe < 0 ) {
+                lo = 0;
+                break;
+            }
+            if( behind(probe) ) {
+                lo = probe + 1;
+                break;
+            }
+            hi = probe;
+        }
+    } else if( positionHint < n && behind(positionHint) ) {
+        lo = positionHint + 1;
+        for( index step = 1; ; step *= 2 ) {
+            const index probe = lo + step - 1;
+            if( probe >= n ) {
+                hi = n;
+                break;
+            }
+            if( ! behind(probe) ) {
+                hi = probe;
+                break;
             }
+            lo = probe + 1;
         }
+    } else {
+        return positionHint;
     }
 
     if( mode == InsertFirst )
-        return offset(std::lower_bound(begin(), end(), value, d));
+        return offset(std::lower_bound(begin() + lo, begin() + hi, value, d.compare()));
     else
-        return offset(std::upper_bound(begin(), end(), value, d));
+        return offset(std::upper_bound(begin() + lo, begin() + hi, value, d.compare()));
 }
 
 template<class Container, class Compare, class SortAlgorithm>
@@ -439,10 +781,44 @@ adaptor<Container, Compare, SortAlgorithm>::insert(T&& value,
                                                    index positionHint)
 {
     const index pos = insertPosition(value, mode, positionHint);
-    d.c.insert(d.c.begin() + pos, std::forward<T>(value));
+    Container& c = edit();
+    c.insert(c.begin() + pos, std::forward<T>(value));
     return pos;
 }
 
+template<class Container, class Compare, class SortAlgorithm>
+template<class InputIterator>
+typename adaptor<Container, Compare, SortAlgorithm>::index_ranges
+adaptor<Container, Compare, SortAlgorithm>::insertRange(InputIterator first, InputIterator last)
+{
+    std::vector<value_type> values(first, last);
+    SortAlgorithm::template sort(values.begin(), values.end(), d.compare());
+
+    index_ranges ranges = insertedRanges(values.cbegin(), values.cend());
+    merge_sorted(edit(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()), d.compare());
+    return ranges;
+}
+
+template<class Container, class Compare, class SortAlgorithm>
+template<class ForwardIterator>
+typename adaptor<Container, Compare, SortAlgorithm>::index_ranges
+adaptor<Container, Compare, SortAlgorithm>::insertedRanges(ForwardIterator first, ForwardIterator last) const
+{
+    // the j-th value ends up behind the j values before it and all the values of the
+    // container not greater than it
+    index_ranges ranges;
+    index pos = 0;
+    for( index j = 0; first != last; ++first, ++j ) {
+        pos = insertPosition(*first, InsertLast, pos);
+        const index row = pos + j;
+        if( ! ranges.empty() && ranges.back().second == row )
+            ++ranges.back().second;
+        else
+            ranges.push_back(std::make_pair(row, row + 1));
+    }
+    return ranges;
+}
+
 template<class Container, class Compare, class SortAlgorithm>
 template<class T>
 typename adaptor<Container, Compare, SortAlgorithm>::index
@@ -453,28 +829,24 @@ adaptor<Container, Compare, SortAlgorithm>::change(index i,
 {
     assert(i >= 0 && i < index(size()));
 
-    const index pos = insertPosition(newValue, mode, newPositionHintBeforeRemove);
+    // without a hint, search outwards from the old position
+    const index pos = insertPosition(newValue, mode,
+                                     newPositionHintBeforeRemove >= 0 ? newPositionHintBeforeRemove : i);
 
     if( pos == i || pos == i + 1) {
-        d.c[i] = std::forward<T>(newValue);
+        edit()[i] = std::forward<T>(newValue);
         return i;
-    } else if( pos < i) {
-        auto first = d.c.begin();
-        std::move_backward(first + pos, first + i, first + i + 1);
-        d.c[pos] = std::forward<T>(newValue);
-        return pos;
-    } else {
-        auto first = d.c.begin();
-        std::move(first + i + 1, first + pos, first + i);
-        d.c[pos - 1] = std::forward<T>(newValue);
-        return pos - 1;
     }
+
+    const index newPos = pos < i ? pos : pos - 1;
+    move_and_assign(edit(), i, newPos, std::forward<T>(newValue));
+    return newPos;
 }
 
 template<class Container, class Compare, class SortAlgorithm>
 Container adaptor<Container, Compare, SortAlgorithm>::takeContainer()
 {
-    Container tmp(std::move(d.c));
+    Container tmp(std::move(edit()));
     d.c = Container();
     return tmp;
 }
@@ -483,7 +855,7 @@ template<class Container, class Compare, class SortAlgorithm>
 template<class T>
 bool adaptor<Container, Compare, SortAlgorithm>::contains(const T &value) const
 {
-    auto range = std::equal_range(begin(), end(), value, d);
+    auto range = std::equal_range(begin(), end(), value, d.compare());
     return std::find(range.first, range.second, value) != range.second;
 }
 
@@ -492,7 +864,7 @@ template<class T>
 typename adaptor<Container, Compare, SortAlgorithm>::size_type
 adaptor<Container, Compare, SortAlgorithm>::count(const T& value) const
 {
-    auto range = std::equal_range(begin(), end(), value, d);
+    auto range = std::equal_range(begin(), end(), value, d.compare());
     return std::count(range.first, range.second, value);
 }
 
@@ -503,9 +875,9 @@ adaptor<Container, Compare, SortAlgorithm>::indexOf(const T& value,
                                                     index from) const
 {
     auto range = std::equal_range(begin() + std::max(index(0), std::min(from, index(size()))),
-                                  end(), value, d);
+                                  end(), value, d.compare());
     auto it = std::find(range.first, range.second, value);
-    return it == range.second ? -1 : offset(range.first);
+    return it == range.second ? -1 : offset(it);
 }
 
 template<class Container, class Compare, class SortAlgorithm>
@@ -515,7 +887,7 @@ adaptor<Container, Compare, SortAlgorithm>::lastIndexOf(const T& value,
                                                         index from) const
 {
     auto range = std::equal_range(begin() + std::max(index(0), std::min(from, index(size()))),
-                                  end(), value, d);
+                                  end(), value, d.compare());
 
     while( range.second != range.first ) {
         --range.second;
@@ -547,7 +919,7 @@ template<class T>
 std::pair<typename adaptor<Container, Compare, SortAlgorithm>::index, typename adaptor<Container, Compare, SortAlgorithm>::index>
 adaptor<Container, Compare, SortAlgorithm>::range(const T& value) const
 {
-    auto range = std::equal_range(begin(), end(), value, d);
+    auto range = std::equal_range(begin(), end(), value, d.compare());
     return std::pair<index, index>(offset(range.first), offset(range.second));
 }
 
@@ -555,7 +927,8 @@ template<class Container, class Compare, class SortAlgorithm>
 void adaptor<Container, Compare, SortAlgorithm>::removeRange(index begin,
                                                              index end)
 {
-    d.c.erase( d.c.begin() + begin, d.c.begin() + end );
+    Container& c = edit();
+    c.erase( c.begin() + begin, c.begin() + end );
 }
 
 template<class Container, class Compare, class SortAlgorithm>
@@ -574,25 +947,55 @@ template<class T>
 typename adaptor<Container, Compare, SortAlgorithm>::index
 adaptor<Container, Compare, SortAlgorithm>::removeAll(const T& value)
 {
-    auto r = std::equal_range(d.c.begin(), d.c.end(), value, d);
+    Container& c = edit();
+    auto r = std::equal_range(c.begin(), c.end(), value, d.compare());
     auto it = std::remove(r.first, r.second, value);
-    auto newEnd = std::move(r.second, d.c.end(), it);
+    auto newEnd = std::move(r.second, c.end(), it);
     const index count = r.second - it;
-    erase(newEnd, d.c.end());
+    erase(newEnd, c.end());
     return count;
 }
 
+template<class Container, class Compare, class SortAlgorithm>
+template<class Predicate>
+typename adaptor<Container, Compare, SortAlgorithm>::index
+adaptor<Container, Compare, SortAlgorithm>::removeIf(Predicate pred)
+{
+    return remove_from_container(edit(), [&pred] (index, const value_type& value) { return bool(pred(value)); });
+}
+
+template<class Container, class Compare, class SortAlgorithm>
+void adaptor<Container, Compare, SortAlgorithm>::removeRanges(const index_ranges& ranges)
+{
+    if( ranges.empty() )
+        return;
+    if( ranges.size() == 1 ) {
+        removeRange(ranges.front().first, ranges.front().second);
+        return;
+    }
+
+    auto range = ranges.cbegin();
+    const auto rangesEnd = ranges.cend();
+    remove_from_container(edit(), [&range, rangesEnd] (index i, const value_type&) {
+        while( range != rangesEnd && range->second <= i )
+            ++range;
+        return range != rangesEnd && range->first <= i;
+    });
+}
+
 template<class Container, class Compare, class SortAlgorithm>
 typename adaptor<Container, Compare, SortAlgorithm>::const_iterator adaptor<Container, Compare, SortAlgorithm>::erase(const_iterator position)
 {
-    return d.c.erase(d.c.begin() + offset(position));
+    Container& c = edit();
+    return c.erase(c.begin() + offset(position));
 }
 
 template<class Container, class Compare, class SortAlgorithm>
 typename adaptor<Container, Compare, SortAlgorithm>::const_iterator adaptor<Container, Compare, SortAlgorithm>::erase(const_iterator first,
                                                                                                                       const_iterator last)
 {
-    return d.c.erase(d.c.begin() + offset(first), d.c.begin() + offset(last));
+    Container& c = edit();
+    return c.erase(c.begin() + offset(first), c.begin() + offset(last));
 }
 
 template<class Container, class Compare, class SortAlgorithm>
@@ -624,8 +1027,9 @@ adaptor<Container, Compare, SortAlgorithm>& adaptor<Container, Compare, SortAlgo
 
     if( other.d == d ) {
         const index i = index(size());
-        d.c.insert(d.c.end(), other.d.c.begin(), other.d.c.end());
-        std::inplace_merge(d.c.begin(), d.c.begin() + i, d.c.end(), d);
+        Container& c = edit();
+        c.insert(c.end(), other.d.c.begin(), other.d.c.end());
+        std::inplace_merge(c.begin(), c.begin() + i, c.end(), d.compare());
     } else {
         *this << other.d.c;
     }
@@ -635,15 +1039,7 @@ adaptor<Container, Compare, SortAlgorithm>& adaptor<Container, Compare, SortAlgo
 template< class Container, class Compare, class SortAlgorithm >
 adaptor<Container, Compare, SortAlgorithm>& adaptor<Container, Compare, SortAlgorithm>::operator<<(const Container& container)
 {
-    const index i = index(size());
-    d.c.reserve(i + container.size());
-    for( auto it = container.begin(), end = container.end(); it != end; ++it )
-        d.c.push_back(*it); // Qt container do not support range insert
-
-    SortAlgorithm::template sort(d.c.begin() + i, d.c.end(), d);
-
-    std::inplace_merge(d.c.begin(), d.c.begin() + i, d.c.end(), d);
-
+    insertRange(container.begin(), container.end());
     return *this;
 }
 
@@ -673,12 +1069,139 @@ adaptor<Container, Compare, SortAlgorithm> adaptor<Container, Compare, SortAlgor
 
     result.reserve(l1.size() + l2.size());
     std::merge(l1.cbegin(), l1.cend(), l2.cbegin(), l2.cend(),
-               std::back_insert_iterator<Container>(result.d.c), result.d);
+               std::back_insert_iterator<Container>(result.d.c), result.d.compare());
 
     return result;
 }
 
 
+template< class Container, class Compare, class SortAlgorithm >
+template< class OtherContainer, class OtherSortAlgorithm, class OnlyThis, class OnlyOther, class Both >
+void adaptor<Container, Compare, SortAlgorithm>::matchWith(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other,
+                                                          OnlyThis onlyThis, OnlyOther onlyOther, Both both) const
+{
+    if( ! same_compare(d.compare(), other.d.compare(), 0) )
+        return;
+
+    const Compare& compare = d.compare();
+    auto a = begin();
+    auto b = other.begin();
+    const auto aEnd = end();
+    const auto bEnd = other.end();
+    index i = 0;
+    index j = 0;
+    std::vector<decltype(b)> bRun;
+    std::vector<bool> matched;
+    // runs up to this long are matched pairwise even if the elements can be hashed
+    const std::size_t pairwiseRunSize = 16;
+    typedef decltype(has_element_hash(static_cast<const value_type*>(nullptr), 0)) hashable;
+
+    while( a != aEnd && b != bEnd ) {
+        if( compare(*a, *b) ) {
+            onlyThis(i++, *a++);
+            continue;
+        }
+        if( compare(*b, *a) ) {
+            onlyOther(j++, *b++);
+            continue;
+        }
+
+        // match up the runs of equivalent values
+        bRun.clear();
+        do {
+            bRun.push_back(b);
+            ++b;
+        } while( b != bEnd && ! compare(*bRun.front(), *b) );
+        matched.assign(bRun.size(), false);
+
+        const auto aRun = a;
+        index aRunSize = 0;
+        for( ; a != aEnd && ! compare(*aRun, *a); ++a )
+            ++aRunSize;
+        if( bRun.size() > pairwiseRunSize )
+            match_run(aRun, a, i, bRun, matched, onlyThis, both, hashable());
+        else
+            match_run(aRun, a, i, bRun, matched, onlyThis, both, std::false_type());
+        i += aRunSize;
+
+        for( std::size_t k = 0; k < bRun.size(); ++k, ++j ) {
+            if( ! matched[k] )
+                onlyOther(j, *bRun[k]);
+        }
+    }
+
+    for( ; a != aEnd; ++a )
+        onlyThis(i++, *a);
+    for( ; b != bEnd; ++b )
+        onlyOther(j++, *b);
+}
+
+template< class Container, class Compare, class SortAlgorithm >
+template< class OtherContainer, class OtherSortAlgorithm >
+adaptor<Container, Compare, SortAlgorithm> adaptor<Container, Compare, SortAlgorithm>::mergeWith(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const
+{
+    adaptor<Container, Compare, SortAlgorithm> result(d.compare());
+    Container& c = result.d.c;
+    c.reserve(size() + other.size());
+    const auto append = [&c] (index, const value_type& value) { c.push_back(value); };
+    matchWith(other, append, append, append);
+    return result;
+}
+
+template< class Container, class Compare, class SortAlgorithm >
+template< class OtherContainer, class OtherSortAlgorithm >
+adaptor<Container, Compare, SortAlgorithm> adaptor<Container, Compare, SortAlgorithm>::intersect(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const
+{
+    adaptor<Container, Compare, SortAlgorithm> result(d.compare());
+    Container& c = result.d.c;
+    const auto append = [&c] (index, const value_type& value) { c.push_back(value); };
+    const auto skip = [] (index, const value_type&) {};
+    matchWith(other, skip, skip, append);
+    return result;
+}
+
+template< class Container, class Compare, class SortAlgorithm >
+template< class OtherContainer, class OtherSortAlgorithm >
+adaptor<Container, Compare, SortAlgorithm> adaptor<Container, Compare, SortAlgorithm>::difference(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const
+{
+    adaptor<Container, Compare, SortAlgorithm> result(d.compare());
+    Container& c = result.d.c;
+    const auto append = [&c] (index, const value_type& value) { c.push_back(value); };
+    const auto skip = [] (index, const value_type&) {};
+    matchWith(other, append, skip, skip);
+    return result;
+}
+
+template< class Container, class Compare, class SortAlgorithm >
+template< class OtherContainer, class OtherSortAlgorithm >
+adaptor<Container, Compare, SortAlgorithm> adaptor<Container, Compare, SortAlgorithm>::symmetricDifference(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const
+{
+    adaptor<Container, Compare, SortAlgorithm> result(d.compare());
+    Container& c = result.d.c;
+    const auto append = [&c] (index, const value_type& value) { c.push_back(value); };
+    const auto skip = [] (index, const value_type&) {};
+    matchWith(other, append, append, skip);
+    return result;
+}
+
+template< class Container, class Compare, class SortAlgorithm >
+template< class OtherContainer, class OtherSortAlgorithm >
+typename adaptor<Container, Compare, SortAlgorithm>::index_ranges
+adaptor<Container, Compare, SortAlgorithm>::differenceRanges(const adaptor<OtherContainer, Compare, OtherSortAlgorithm>& other) const
+{
+    index_ranges ranges;
+    const auto add = [&ranges] (index i, const value_type&) {
+        if( ! ranges.empty() && ranges.back().second == i )
+            ++ranges.back().second;
+        else
+            ranges.push_back(std::pair<index, index>(i, i + 1));
+    };
+    const auto skip = [] (index, const value_type&) {};
+    matchWith(other, add, skip, skip);
+    return ranges;
+}
+
+
 } // namespace sorted_sequence
 
 #endif // SORTED_SEQUENCE_H
@@ -17,6 +17,129 @@
  */
 
 #include "formgencompositionmodels.h"
+#include "formgenrowruns_p.h"
+#include "formgenschemabase.h"
+#include "formgenschemabase_p.h"
+#include "order_statistic_tree.h"
+
+#include <QCollator>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+#include <vector>
+
+
+// Reconciling falls back to a model reset beyond this many differing rows, which
+// also bounds the memory of the list diff (quadratic in the number of differences).
+static const int s_maxReconcileEdits = 1024;
+
+// Myers' O(ND) difference of the n rows of a and the m rows of b, both starting at
+// offset: marks the rows of a longest common subsequence in keptA and keptB. Returns
+// false if the rows differ in more than maxEdits removals and insertions.
+static bool markCommonRows(const QVariantList &a, int n, const QVariantList &b, int m, int offset,
+                           int maxEdits, QVector<bool> *keptA, QVector<bool> *keptB)
+{
+    // the difference in size alone takes that many edits
+    if( qAbs(n - m) > maxEdits )
+        return false;
+
+    // v[center + k] is the furthest x reached on diagonal k = x - y, trace keeps it for
+    // every edit count to walk the path back
+    const int center = maxEdits + 1;
+    QVector<int> v(2 * center + 1, 0);
+    QVector< QVector<int> > trace;
+
+    int edits = 0;
+    for( ; edits <= maxEdits; ++edits ) {
+        bool done = false;
+        for( int k = -edits; k <= edits && ! done; k += 2 ) {
+            int x;
+            if( k == -edits || (k != edits && v[center + k - 1] < v[center + k + 1]) )
+                x = v[center + k + 1];
+            else
+                x = v[center + k - 1] + 1;
+            int y = x - k;
+            while( x < n && y < m && a.at(offset + x) == b.at(offset + y) ) {
+                ++x;
+                ++y;
+            }
+            v[center + k] = x;
+            done = x >= n && y >= m;
+        }
+        trace.append(v.mid(center - edits, 2 * edits + 1));
+        if( done )
+            break;
+    }
+    if( edits > maxEdits )
+        return false;
+
+    keptA->fill(false, n);
+    keptB->fill(false, m);
+    int x = n;
+    int y = m;
+    for( int d = edits; d > 0; --d ) {
+        const QVector<int> &prev = trace.at(d - 1);
+        const int k = x - y;
+        const bool down = k == -d || (k != d && prev.at(k - 1 + d - 1) < prev.at(k + 1 + d - 1));
+        const int prevK = down ? k + 1 : k - 1;
+        const int prevX = prev.at(prevK + d - 1);
+        const int snakeStart = down ? prevX : prevX + 1;
+        while( x > snakeStart ) {
+            --x;
+            --y;
+            (*keptA)[x] = true;
+            (*keptB)[y] = true;
+        }
+        x = prevX;
+        y = prevX - prevK;
+    }
+    while( x > 0 ) {
+        --x;
+        --y;
+        (*keptA)[x] = true;
+        (*keptB)[y] = true;
+    }
+    return true;
+}
+
+// Hash agreeing with QVariant equality for the values the elements produce, so equal
+// rows can be matched without comparing every pair. Values that only compare equal
+// across types (e.g. 1 and 1.0) may hash differently, which just loses the match.
+static uint variantFingerprint(const QVariant &v)
+{
+    switch( v.userType() ) {
+    case QMetaType::QVariantHash: {
+        // independent of the iteration order, like hash equality
+        uint h = 0;
+        const QVariantHash &hash = formGenBorrowedHash(v);
+        for( auto it = hash.cbegin(); it != hash.cend(); ++it )
+            h += qHash(it.key()) ^ variantFingerprint(it.value());
+        return h;
+    }
+    case QMetaType::QVariantList: {
+        uint h = 0;
+        for( const auto &item : formGenBorrowedList(v) )
+            h = 31 * h + variantFingerprint(item);
+        return h;
+    }
+    case QMetaType::QString:
+        return qHash(*static_cast<const QString *>(v.constData()));
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return qHash(v.toLongLong());
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return qHash(v.toDouble());
+    default:
+        return qHash(v.toString());
+    }
+}
+
 
 FormGenListModel::FormGenListModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -106,6 +229,35 @@ void FormGenListModel::removeRow(int row)
     endRemoveRows();
 }
 
+void FormGenListModel::removeRows(const QList<int> &rows)
+{
+    removeRuns(formGenRowRuns(rows.toVector(), mDataItems.size()));
+}
+
+int FormGenListModel::removeIf(const RowPredicate &matches)
+{
+    const auto runs = formGenMatchingRuns(mDataItems.size(), [this, &matches] (int row) {
+        return matches(mDataItems.at(row));
+    });
+    removeRuns(runs);
+    return formGenRunsSize(runs);
+}
+
+void FormGenListModel::removeRuns(const QVector<QPair<int, int> > &runs)
+{
+    formGenRemoveRuns(runs, mDataItems.size(), [this] (int first, int last) {
+        beginRemoveRows(QModelIndex(), first, last - 1);
+        mDataItems.erase(mDataItems.begin() + first, mDataItems.begin() + last);
+        mDisplayItems.erase(mDisplayItems.begin() + first, mDisplayItems.begin() + last);
+        endRemoveRows();
+    }, [this, &runs] {
+        beginResetModel();
+        mDataItems = formGenWithoutRuns(mDataItems, runs);
+        mDisplayItems = formGenWithoutRuns(mDisplayItems, runs);
+        endResetModel();
+    });
+}
+
 void FormGenListModel::moveRow(int sourceRow, int targetRow)
 {
     if (sourceRow == targetRow || sourceRow < 0 || targetRow < 0 || sourceRow >= mDataItems.size() || targetRow >= mDataItems.size())
@@ -128,25 +280,499 @@ void FormGenListModel::clear()
     endResetModel();
 }
 
+void FormGenListModel::appendRows(const QStringList &displays, const QVariantList &data)
+{
+    if( displays.size() != data.size() || data.isEmpty() )
+        return;
+
+    const int first = mDataItems.size();
+    beginInsertRows(QModelIndex(), first, first + data.size() - 1);
+    mDataItems.append(data);
+    mDisplayItems.append(displays);
+    endInsertRows();
+}
+
+void FormGenListModel::resetRows(const QStringList &displays, const QVariantList &data)
+{
+    if( displays.size() != data.size() )
+        return;
+
+    beginResetModel();
+    mDataItems = data;
+    mDisplayItems = displays;
+    endResetModel();
+}
+
+bool FormGenListModel::reconcile(const QVariantList &newData, const DisplayFunction &display)
+{
+    const int oldSize = mDataItems.size();
+    const int newSize = newData.size();
+
+    // the common prefix and suffix stay as they are without diffing them
+    int prefix = 0;
+    while( prefix < oldSize && prefix < newSize && mDataItems.at(prefix) == newData.at(prefix) )
+        ++prefix;
+    int suffix = 0;
+    while( suffix < oldSize - prefix && suffix < newSize - prefix
+           && mDataItems.at(oldSize - 1 - suffix) == newData.at(newSize - 1 - suffix) )
+        ++suffix;
+
+    const int n = oldSize - prefix - suffix;
+    const int m = newSize - prefix - suffix;
+    if( n == 0 && m == 0 )
+        return false;
+
+    QVector<bool> keptOld, keptNew;
+    if( ! markCommonRows(mDataItems, n, newData, m, prefix, s_maxReconcileEdits, &keptOld, &keptNew) ) {
+        QStringList displayItems;
+        displayItems.reserve(newSize);
+        for( int i = 0; i < newSize; ++i ) {
+            if( i < prefix )
+                displayItems.append(mDisplayItems.at(i));
+            else if( i >= newSize - suffix )
+                displayItems.append(mDisplayItems.at(i - newSize + oldSize));
+            else
+                displayItems.append(display(newData.at(i)));
+        }
+
+        resetRows(displayItems, newData);
+        return true;
+    }
+
+    // each hunk replaces a run of rows that are not kept by a run of new rows
+    struct Hunk {
+        int oldRow, oldCount, newRow, newCount;
+    };
+    QVector<Hunk> hunks;
+    for( int i = 0, j = 0; i < n || j < m; ) {
+        if( i < n && j < m && keptOld.at(i) && keptNew.at(j) ) {
+            ++i;
+            ++j;
+            continue;
+        }
+        Hunk hunk = { prefix + i, 0, prefix + j, 0 };
+        for( ; i < n && ! keptOld.at(i); ++i )
+            ++hunk.oldCount;
+        for( ; j < m && ! keptNew.at(j); ++j )
+            ++hunk.newCount;
+        hunks.append(hunk);
+    }
+
+    // apply from the back, so the old row numbers of the remaining hunks stay valid;
+    // rows replaced in place become edits instead of a removal and an insertion
+    for( int h = hunks.size() - 1; h >= 0; --h ) {
+        const Hunk &hunk = hunks.at(h);
+        const int edited = qMin(hunk.oldCount, hunk.newCount);
+
+        for( int r = 0; r < edited; ++r ) {
+            const QVariant &data = newData.at(hunk.newRow + r);
+            mDisplayItems[hunk.oldRow + r] = display(data);
+            mDataItems[hunk.oldRow + r] = data;
+        }
+        if( edited > 0 )
+            emit dataChanged(index(hunk.oldRow), index(hunk.oldRow + edited - 1));
+
+        const int first = hunk.oldRow + edited;
+        if( hunk.oldCount > edited ) {
+            const int last = hunk.oldRow + hunk.oldCount - 1;
+            beginRemoveRows(QModelIndex(), first, last);
+            mDataItems.erase(mDataItems.begin() + first, mDataItems.begin() + last + 1);
+            mDisplayItems.erase(mDisplayItems.begin() + first, mDisplayItems.begin() + last + 1);
+            endRemoveRows();
+        } else if( hunk.newCount > edited ) {
+            const int count = hunk.newCount - edited;
+            QStringList displayItems;
+            displayItems.reserve(count);
+            for( int r = 0; r < count; ++r )
+                displayItems.append(display(newData.at(hunk.newRow + edited + r)));
+
+            beginInsertRows(QModelIndex(), first, first + count - 1);
+            for( int r = 0; r < count; ++r ) {
+                mDataItems.insert(first + r, newData.at(hunk.newRow + edited + r));
+                mDisplayItems.insert(first + r, displayItems.at(r));
+            }
+            endInsertRows();
+        }
+    }
+
+    return true;
+}
+
+
+// A typed sort key extracted from a row value, see FormGenBagModel::setSortKeys.
+struct FormGenBagFieldKey {
+    enum Kind {
+        Missing, Number, Time, Text
+    };
+
+    Kind kind;
+    bool isReal;
+    qint64 integer; // also the index into FormGenBagRow::textKeys for Text
+    double real;
+};
+
+// A stored row: the element plus the sort keys of the active order, extracted once, so
+// comparisons neither collate the display strings nor dig into the values repeatedly.
+struct FormGenBagRow {
+    FormGenBagModel::DataElement element;
+    QCollatorSortKey sortKey;
+    std::vector<FormGenBagFieldKey> fieldKeys;
+    std::vector<QCollatorSortKey> textKeys;
+};
+
+// Orders rows by their cached keys; only a custom Compare goes through std::function.
+struct FormGenBagRowCompare {
+    enum Mode {
+        BySortKey, ByCompare, ByFieldKeys
+    };
+
+    FormGenBagRowCompare(Mode mode_, const FormGenBagModel::Compare &compare_,
+                         const QVector<bool> &descending_ = QVector<bool>())
+        : mode(mode_)
+        , compare(compare_)
+        , descending(descending_)
+    {}
+
+    bool operator()(const FormGenBagRow &lhs, const FormGenBagRow &rhs) const
+    {
+        switch( mode ) {
+        case BySortKey:
+            return lhs.sortKey.compare(rhs.sortKey) < 0;
+        case ByFieldKeys:
+            for( int k = 0; k < descending.size(); ++k ) {
+                const int c = compareFieldKeys(lhs, rhs, k);
+                if( c != 0 )
+                    return descending.at(k) ? c > 0 : c < 0;
+            }
+            return false;
+        case ByCompare:
+            break;
+        }
+        return compare(lhs.element, rhs.element);
+    }
+
+    bool operator==(const FormGenBagRowCompare &other) const
+    {
+        return mode == other.mode && compare == other.compare && descending == other.descending;
+    }
+
+    bool operator!=(const FormGenBagRowCompare &other) const
+    {
+        return ! operator==(other);
+    }
+
+    static int compareFieldKeys(const FormGenBagRow &lhs, const FormGenBagRow &rhs, int k)
+    {
+        const FormGenBagFieldKey &a = lhs.fieldKeys[k];
+        const FormGenBagFieldKey &b = rhs.fieldKeys[k];
+        if( a.kind != b.kind )
+            return a.kind < b.kind ? -1 : 1;
+
+        switch( a.kind ) {
+        case FormGenBagFieldKey::Missing:
+            return 0;
+        case FormGenBagFieldKey::Number:
+            if( a.isReal || b.isReal ) {
+                const double x = a.isReal ? a.real : double(a.integer);
+                const double y = b.isReal ? b.real : double(b.integer);
+                return x < y ? -1 : (y < x ? 1 : 0);
+            }
+            // fall through
+        case FormGenBagFieldKey::Time:
+            return a.integer < b.integer ? -1 : (b.integer < a.integer ? 1 : 0);
+        case FormGenBagFieldKey::Text:
+            return lhs.textKeys[a.integer].compare(rhs.textKeys[b.integer]);
+        }
+        return 0;
+    }
+
+    Mode mode;
+    FormGenBagModel::Compare compare; // the same order on elements, for ByCompare
+    QVector<bool> descending;         // per field key, for ByFieldKeys
+};
+
+// rows match by their elements, the keys follow from them
+static bool operator==(const FormGenBagRow &lhs, const FormGenBagRow &rhs)
+{
+    return lhs.element == rhs.element;
+}
+
+// lets the diff of a bag match long runs of equivalent rows (e.g. by a coarse sort key) by hash
+static std::size_t element_hash(const FormGenBagRow &row)
+{
+    return qHash(row.element.first) ^ variantFingerprint(row.element.second);
+}
+
+
+// The default order of the bag rows on elements, collating the display strings.
+static const FormGenBagModel::Compare &collationCompare()
+{
+    static const QCollator collator;
+    static const FormGenBagModel::Compare byCollation([] (const FormGenBagModel::DataElement &lhs,
+                                                          const FormGenBagModel::DataElement &rhs) {
+        return collator.compare(lhs.first, rhs.first) < 0;
+    });
+    return byCollation;
+}
+
+
+template< class Container >
+class FormGenBagModel::ItemsImpl : public FormGenBagModel::Items {
+public:
+    typedef sorted_sequence::adaptor< Container, FormGenBagRowCompare > Sequence;
+
+    // comparison if given, else the sort keys if any, else the collated display strings
+    ItemsImpl(const Compare *comparison, const QVector<SortKey> &keys,
+              const QVector<DataElement> &elements, QHash<int, int> *oldToNew, bool parallel)
+        : mSequence(rowCompare(comparison, keys))
+        , mEmptyKey(mCollator.sortKey(QString()))
+    {
+        if( ! comparison ) {
+            for( const auto &key : keys )
+                mKeyPaths.append(FormGenPath::fromString(key.path));
+        }
+
+        const FormGenBagRowCompare compare = mSequence.compareOperator();
+        mSequence = Sequence(sorted_sequence::presorted, sortedRows(elements, oldToNew, parallel), compare);
+    }
+
+    // takes the rows of other with their keys
+    template< class OtherContainer >
+    explicit ItemsImpl(ItemsImpl<OtherContainer> &other)
+        : mSequence(sorted_sequence::presorted, containerOf(flatRows(other.mSequence.takeContainer())),
+                    other.mSequence.compareOperator())
+        , mKeyPaths(other.mKeyPaths)
+        , mEmptyKey(other.mEmptyKey)
+    {
+    }
+
+    int size() const override { return int(mSequence.size()); }
+    const DataElement &at(int row) const override { return mSequence.at(row).element; }
+
+    int insertPosition(const DataElement &element, int positionHint) const override
+    {
+        return int(mSequence.insertPosition(lookupRow(element), sorted_sequence::InsertLast, positionHint));
+    }
+
+    void insert(const DataElement &element, int row) override
+    {
+        mSequence.insert(takeLookupRow(element), sorted_sequence::InsertLast, row);
+    }
+
+    void change(int row, const DataElement &element, int newRowBeforeRemove) override
+    {
+        mSequence.change(row, takeLookupRow(element, &mSequence.at(row)), sorted_sequence::InsertLast,
+                         newRowBeforeRemove);
+    }
+
+    void removeRange(int begin, int end) override { mSequence.removeRange(begin, end); }
+
+    void removeRuns(const QVector<QPair<int, int> > &runs) override
+    {
+        typename Sequence::index_ranges ranges;
+        ranges.reserve(runs.size());
+        for( const auto &run : runs )
+            ranges.push_back(std::make_pair(typename Sequence::index(run.first), typename Sequence::index(run.second)));
+        mSequence.removeRanges(ranges);
+    }
+
+    void clear() override { mSequence.clear(); }
+
+    void merge(const QVector<DataElement> &elements, const RunFunction &aboutToInsert,
+               const RunFunction &inserted) override
+    {
+        std::vector<FormGenBagRow> batch;
+        batch.reserve(elements.size());
+        for( const auto &element : elements )
+            batch.push_back(makeRow(element));
+        mergeRuns(mSequence, batch, aboutToInsert, inserted);
+    }
+
+    void diff(const QVector<DataElement> &elements, QVector<QPair<int, int> > *missingRows,
+              QVector<DataElement> *additional) const override
+    {
+        const Sequence other(sorted_sequence::presorted, sortedRows(elements, nullptr, false),
+                             mSequence.compareOperator());
+        for( const auto &run : mSequence.differenceRanges(other) )
+            missingRows->append(qMakePair(int(run.first), int(run.second)));
+        for( const auto &run : other.differenceRanges(mSequence) ) {
+            for( auto i = run.first; i < run.second; ++i )
+                additional->append(other.at(i).element);
+        }
+    }
+
+    Items *moveTo(Storage storage) override;
+
+    QVector<DataElement> takeAll() override
+    {
+        mLookupRow.clear();
+        std::vector<FormGenBagRow> rows = flatRows(mSequence.takeContainer());
+        QVector<DataElement> elements;
+        elements.reserve(int(rows.size()));
+        for( auto &row : rows )
+            elements.append(std::move(row.element));
+        return elements;
+    }
+
+private:
+    template< class > friend class ItemsImpl;
+
+    static FormGenBagRowCompare rowCompare(const Compare *comparison, const QVector<SortKey> &keys)
+    {
+        if( comparison )
+            return FormGenBagRowCompare(FormGenBagRowCompare::ByCompare, *comparison);
+        if( keys.isEmpty() )
+            return FormGenBagRowCompare(FormGenBagRowCompare::BySortKey, collationCompare());
+
+        QVector<bool> descending;
+        for( const auto &key : keys )
+            descending.append(key.direction == Descending);
+        return FormGenBagRowCompare(FormGenBagRowCompare::ByFieldKeys, collationCompare(), descending);
+    }
+
+    // the rows of elements in the order of mSequence
+    Container sortedRows(const QVector<DataElement> &elements, QHash<int, int> *oldToNew, bool parallel) const
+    {
+        std::vector<FormGenBagRow> rows;
+        rows.reserve(elements.size());
+        for( const auto &element : elements )
+            rows.push_back(makeRow(element));
+        sortRows(rows, mSequence.compareOperator(), oldToNew, parallel);
+        return containerOf(std::move(rows));
+    }
+
+    static Container containerOf(std::vector<FormGenBagRow> &&rows)
+    {
+        Container container;
+        assignRows(container, std::move(rows));
+        return container;
+    }
+
+    // reuses the keys of old where its element is the same
+    FormGenBagRow makeRow(const DataElement &element, const FormGenBagRow *old = nullptr) const
+    {
+        const FormGenBagRowCompare::Mode mode = mSequence.compareOperator().mode;
+        FormGenBagRow row = { element, mEmptyKey, {}, {} };
+        if( mode == FormGenBagRowCompare::BySortKey ) {
+            row.sortKey = old && old->element.first == element.first ? old->sortKey
+                                                                      : mCollator.sortKey(element.first);
+        } else if( mode == FormGenBagRowCompare::ByFieldKeys ) {
+            if( old && old->element.second == element.second ) {
+                row.fieldKeys = old->fieldKeys;
+                row.textKeys = old->textKeys;
+            } else {
+                setFieldKeys(&row);
+            }
+        }
+        return row;
+    }
+
+    // insertRow and editRow look up the position of a row before inserting it
+    const FormGenBagRow &lookupRow(const DataElement &element) const
+    {
+        if( mLookupRow.empty() || mLookupRow.front().element != element )
+            mLookupRow.assign(1, makeRow(element));
+        return mLookupRow.front();
+    }
+
+    FormGenBagRow takeLookupRow(const DataElement &element, const FormGenBagRow *old = nullptr)
+    {
+        if( mLookupRow.empty() || mLookupRow.front().element != element )
+            return makeRow(element, old);
+        FormGenBagRow row = std::move(mLookupRow.front());
+        mLookupRow.clear();
+        return row;
+    }
+
+    void setFieldKeys(FormGenBagRow *row) const
+    {
+        row->fieldKeys.clear();
+        row->textKeys.clear();
+        row->fieldKeys.reserve(mKeyPaths.size());
+
+        for( const auto &path : mKeyPaths ) {
+            const QVariant v = FormGenSchemaBase::variantAt(row->element.second, path);
+            FormGenBagFieldKey key = { FormGenBagFieldKey::Missing, false, 0, 0.0 };
+
+            switch( v.userType() ) {
+            case QMetaType::Bool:
+            case QMetaType::Int:
+            case QMetaType::UInt:
+            case QMetaType::LongLong:
+            case QMetaType::ULongLong:
+                key.kind = FormGenBagFieldKey::Number;
+                key.integer = v.toLongLong();
+                break;
+            case QMetaType::Double:
+            case QMetaType::Float:
+                key.kind = FormGenBagFieldKey::Number;
+                key.isReal = true;
+                key.real = v.toDouble();
+                break;
+            case QMetaType::QDate:
+                key.kind = FormGenBagFieldKey::Time;
+                key.integer = v.toDate().toJulianDay();
+                break;
+            case QMetaType::QTime:
+                key.kind = FormGenBagFieldKey::Time;
+                key.integer = v.toTime().msecsSinceStartOfDay();
+                break;
+            case QMetaType::QDateTime:
+                key.kind = FormGenBagFieldKey::Time;
+                key.integer = v.toDateTime().toMSecsSinceEpoch();
+                break;
+            default:
+                if( v.isValid() && v.canConvert<QString>() ) {
+                    key.kind = FormGenBagFieldKey::Text;
+                    key.integer = qint64(row->textKeys.size());
+                    row->textKeys.push_back(mCollator.sortKey(v.toString()));
+                }
+                break;
+            }
+
+            row->fieldKeys.push_back(key);
+        }
+    }
+
+    Sequence mSequence;
+    QVector<FormGenPath> mKeyPaths;
+    const QCollator mCollator;
+    const QCollatorSortKey mEmptyKey;
+    mutable std::vector<FormGenBagRow> mLookupRow; // at most one, the row type has no default constructor
+};
+
+template< class Container >
+FormGenBagModel::Items *FormGenBagModel::ItemsImpl<Container>::moveTo(Storage storage)
+{
+    if( storage == TreeStorage )
+        return new ItemsImpl< sorted_sequence::order_statistic_tree<FormGenBagRow> >(*this);
+    return new ItemsImpl< std::vector<FormGenBagRow> >(*this);
+}
+
 
 FormGenBagModel::FormGenBagModel(QObject *parent)
     : QAbstractListModel(parent)
-    , mItems(Compare([] (const DataElement &lhs, const DataElement &rhs) {
-                return QString::localeAwareCompare(lhs.first, rhs.first) < 0;
-             }))
+    , mStorage(VectorStorage)
+    , mParallelSorting(false)
+    , mItems(sortedItems(VectorStorage, nullptr, {}, {}, nullptr, false))
 {
 }
 
+FormGenBagModel::~FormGenBagModel()
+{
+    delete mItems;
+}
+
 QVariant FormGenBagModel::data(const QModelIndex &index, int role) const
 {
-    if( index.row() < 0 || index.row() >= mItems.size() )
+    if( index.row() < 0 || index.row() >= mItems->size() )
         return {};
 
     switch( role ) {
     case Qt::DisplayRole:
-        return mItems.at(index.row()).first;
+        return mItems->at(index.row()).first;
     case Qt::EditRole:
-        return mItems.at(index.row()).second;
+        return mItems->at(index.row()).second;
     }
 
     return {};
@@ -157,32 +783,33 @@ int FormGenBagModel::rowCount(const QModelIndex &parent) const
     if( parent.isValid() )
         return 0;
 
-    return mItems.size();
+    return mItems->size();
 }
 
 int FormGenBagModel::insertRow(const QString &display, const QVariant &data)
 {
     const auto pair = QPair<QString, QVariant>(display, data);
-    const int row = mItems.insertPosition(pair);
+    const int row = mItems->insertPosition(pair, -1);
     beginInsertRows(QModelIndex(), row, row);
-    mItems.insert(pair, sorted_sequence::InsertLast, row);
+    mItems->insert(pair, row);
     endInsertRows();
     return row;
 }
 
 int FormGenBagModel::editRow(int row, const QString &newDisplay, const QVariant &newData)
 {
-    if( row < 0 || row >= mItems.size() )
+    if( row < 0 || row >= mItems->size() )
         return -1;
 
     const auto pair = QPair<QString, QVariant>(newDisplay, newData);
-    const int newRow = mItems.insertPosition(pair);
+    // edits mostly move a row a little, if at all
+    const int newRow = mItems->insertPosition(pair, row);
     const int newRowAfterRemove = newRow > row ? newRow - 1 : newRow;
     const bool needMove = newRowAfterRemove != row;
 
     if( needMove )
         beginMoveRows(QModelIndex(), row, row, QModelIndex(), newRow);
-    mItems.change(row, pair, sorted_sequence::InsertLast, newRow);
+    mItems->change(row, pair, newRow);
     if( needMove )
         endMoveRows();
     emit dataChanged(index(newRow), index(newRow));
@@ -191,22 +818,230 @@ int FormGenBagModel::editRow(int row, const QString &newDisplay, const QVariant
 
 void FormGenBagModel::removeRow(int row)
 {
-    if( row < 0 || row >= mItems.size() )
+    if( row < 0 || row >= mItems->size() )
         return;
 
     beginRemoveRows(QModelIndex(), row, row);
-    mItems.removeAt(row);
+    mItems->removeRange(row, row + 1);
     endRemoveRows();
 }
 
+void FormGenBagModel::removeRows(const QList<int> &rows)
+{
+    removeRuns(formGenRowRuns(rows.toVector(), mItems->size()));
+}
+
+int FormGenBagModel::removeIf(const RowPredicate &matches)
+{
+    const auto runs = formGenMatchingRuns(mItems->size(), [this, &matches] (int row) {
+        return matches(mItems->at(row).second);
+    });
+    removeRuns(runs);
+    return formGenRunsSize(runs);
+}
+
 void FormGenBagModel::clear()
 {
     beginResetModel();
-    mItems.clear();
+    mItems->clear();
+    endResetModel();
+}
+
+void FormGenBagModel::appendRows(const QStringList &displays, const QVariantList &data)
+{
+    if( displays.size() != data.size() || data.isEmpty() )
+        return;
+
+    mergeRows(dataElements(displays, data));
+}
+
+void FormGenBagModel::resetRows(const QStringList &displays, const QVariantList &data)
+{
+    if( displays.size() != data.size() )
+        return;
+
+    beginResetModel();
+    mItems->clear();
+    mItems->merge(dataElements(displays, data), nullptr, nullptr);
     endResetModel();
 }
 
+bool FormGenBagModel::reconcile(const QVariantList &newData, const DisplayFunction &display)
+{
+    // bucket the rows by fingerprint, then let every new value claim an equal row
+    QHash<uint, QVector<int> > unclaimedRows;
+    for( int row = 0; row < mItems->size(); ++row )
+        unclaimedRows[variantFingerprint(mItems->at(row).second)].append(row);
+
+    QVector<bool> claimed(mItems->size(), false);
+    QVector<DataElement> added;
+    for( const auto &v : newData ) {
+        bool found = false;
+        const auto it = unclaimedRows.find(variantFingerprint(v));
+        if( it != unclaimedRows.end() ) {
+            QVector<int> &rows = it.value();
+            for( int i = rows.size() - 1; i >= 0; --i ) {
+                if( mItems->at(rows.at(i)).second == v ) {
+                    claimed[rows.at(i)] = true;
+                    rows.remove(i);
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if( ! found )
+            added.append(DataElement(QString(), v));
+    }
+
+    const int removedCount = mItems->size() - (newData.size() - added.size());
+    if( removedCount == 0 && added.isEmpty() )
+        return false;
+
+    for( auto &element : added )
+        element.first = display(element.second);
+
+    QVector<QPair<int, int> > removedRuns;
+    for( int row = 0; row < mItems->size(); ) {
+        if( claimed.at(row) ) {
+            ++row;
+            continue;
+        }
+        const int first = row;
+        while( row < mItems->size() && ! claimed.at(row) )
+            ++row;
+        removedRuns.append(qMakePair(first, row));
+    }
+
+    replaceRuns(removedRuns, added);
+    return true;
+}
+
+bool FormGenBagModel::replaceRows(const QStringList &displays, const QVariantList &data)
+{
+    if( displays.size() != data.size() )
+        return false;
+
+    QVector<QPair<int, int> > removedRuns;
+    QVector<DataElement> added;
+    mItems->diff(dataElements(displays, data), &removedRuns, &added);
+    if( removedRuns.isEmpty() && added.isEmpty() )
+        return false;
+
+    replaceRuns(removedRuns, added);
+    return true;
+}
+
+// removes the ascending [first, last) runs of rows, see FormGenListModel::removeRows
+void FormGenBagModel::removeRuns(const QVector<QPair<int, int> > &runs)
+{
+    formGenRemoveRuns(runs, mItems->size(), [this] (int first, int last) {
+        beginRemoveRows(QModelIndex(), first, last - 1);
+        mItems->removeRange(first, last);
+        endRemoveRows();
+    }, [this, &runs] {
+        beginResetModel();
+        mItems->removeRuns(runs);
+        endResetModel();
+    });
+}
+
+bool FormGenBagModel::signalsRunsSeparately(const QVector<QPair<int, int> > &runs, int rowCount)
+{
+    return formGenSignalsRunsSeparately(runs, rowCount);
+}
+
+// removes the ascending [first, last) runs of rows, then sorts in added
+void FormGenBagModel::replaceRuns(const QVector<QPair<int, int> > &removedRuns, const QVector<DataElement> &added)
+{
+    if( formGenRunsSize(removedRuns) + added.size() > s_maxReconcileEdits ) {
+        beginResetModel();
+        mItems->removeRuns(removedRuns);
+        mItems->merge(added, nullptr, nullptr);
+        endResetModel();
+        return;
+    }
+
+    removeRuns(removedRuns);
+    mergeRows(added);
+}
+
+void FormGenBagModel::mergeRows(const QVector<DataElement> &elements)
+{
+    mItems->merge(elements, [this] (int first, int last) {
+        if( first < 0 )
+            beginResetModel();
+        else
+            beginInsertRows(QModelIndex(), first, last - 1);
+    }, [this] (int first, int) {
+        if( first < 0 )
+            endResetModel();
+        else
+            endInsertRows();
+    });
+}
+
+QVector<FormGenBagModel::DataElement> FormGenBagModel::dataElements(const QStringList &displays,
+                                                                  const QVariantList &data)
+{
+    QVector<DataElement> elements;
+    elements.reserve(data.size());
+    for( int i = 0; i < data.size(); ++i )
+        elements.append(DataElement(displays.at(i), data.at(i)));
+    return elements;
+}
+
+FormGenBagModel::Storage FormGenBagModel::storage() const
+{
+    return mStorage;
+}
+
+void FormGenBagModel::setStorage(Storage storage)
+{
+    if( storage == mStorage )
+        return;
+
+    Items *items = mItems->moveTo(storage);
+    delete mItems;
+    mItems = items;
+    mStorage = storage;
+}
+
+bool FormGenBagModel::parallelSorting() const
+{
+    return mParallelSorting;
+}
+
+void FormGenBagModel::setParallelSorting(bool enabled)
+{
+    mParallelSorting = enabled;
+}
+
 void FormGenBagModel::setCompareOperator(const Compare &comparison)
+{
+    reorderRows([this, &comparison] (QHash<int, int> *oldToNew) {
+        return sortedItems(mStorage, &comparison, {}, mItems->takeAll(), oldToNew, mParallelSorting);
+    });
+}
+
+void FormGenBagModel::setSortKeys(const QVector<SortKey> &keys)
+{
+    reorderRows([this, &keys] (QHash<int, int> *oldToNew) {
+        return sortedItems(mStorage, nullptr, keys, mItems->takeAll(), oldToNew, mParallelSorting);
+    });
+}
+
+FormGenBagModel::Items *FormGenBagModel::sortedItems(Storage storage, const Compare *comparison,
+                                                     const QVector<SortKey> &keys,
+                                                     const QVector<DataElement> &elements,
+                                                     QHash<int, int> *oldToNew, bool parallel)
+{
+    if( storage == TreeStorage )
+        return new ItemsImpl< sorted_sequence::order_statistic_tree<FormGenBagRow> >(comparison, keys, elements,
+                                                                                     oldToNew, parallel);
+    return new ItemsImpl< std::vector<FormGenBagRow> >(comparison, keys, elements, oldToNew, parallel);
+}
+
+void FormGenBagModel::reorderRows(const std::function<Items *(QHash<int, int> *)> &resort)
 {
     emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
 
@@ -217,7 +1052,9 @@ void FormGenBagModel::setCompareOperator(const Compare &comparison)
             persistentRows.insert(idx.row(), -1);
     }
 
-    mItems.setCompareOperatorGetReorderMap(comparison, &persistentRows);
+    Items *items = resort(&persistentRows);
+    delete mItems;
+    mItems = items;
 
     {
         QModelIndexList oldList, newList;
@@ -19,10 +19,16 @@
 #ifndef FORMGENWIDGETS_QT_COMPOSITIONMODELS_H
 #define FORMGENWIDGETS_QT_COMPOSITIONMODELS_H
 
+#include "order_statistic_tree.h"
 #include "sorted_sequence.h"
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QPair>
+#include <QVector>
+
+#include <functional>
+#include <vector>
 
 #include "formgenwidgets_global.h"
 
@@ -31,6 +37,11 @@ class FORMGENWIDGETS_EXPORT FormGenListModel : public QAbstractListModel {
     Q_OBJECT
 
 public:
+    /// Renders the display string of a row value.
+    typedef std::function<QString (const QVariant &)> DisplayFunction;
+    /// Selects rows by their value.
+    typedef std::function<bool (const QVariant &)> RowPredicate;
+
     FormGenListModel(QObject * parent = 0);
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
@@ -41,10 +52,34 @@ public:
     void appendRow(const QString &display, const QVariant &data);
     void insertRow(int row, const QString &display, const QVariant &data);
     void removeRow(int row);
+    using QAbstractListModel::removeRows;
+    /**
+     * Removes the given rows (in any order) in one go: one range removal per run of
+     * adjacent rows, or a single model reset if the rows are spread too widely.
+     */
+    void removeRows(const QList<int> &rows);
+    /// Removes the rows whose value matches, like removeRows. Returns their number.
+    int removeIf(const RowPredicate &matches);
     void moveRow(int sourceRow, int targetRow);
     void clear();
 
+    /// Appends the pre-rendered rows with a single range insert.
+    void appendRows(const QStringList &displays, const QVariantList &data);
+    /// Replaces all rows with a single model reset.
+    void resetRows(const QStringList &displays, const QVariantList &data);
+
+    /**
+     * Turns the rows into newData with the fewest row edits, removals and insertions
+     * (rows are matched by a longest common subsequence), so views keep their selection
+     * and scroll position. display is only called for the edited and inserted rows.
+     * If the lists differ in too many rows, the model is reset instead.
+     * Returns whether any row changed.
+     */
+    bool reconcile(const QVariantList &newData, const DisplayFunction &display);
+
 private:
+    void removeRuns(const QVector<QPair<int, int> > &runs);
+
     QStringList mDisplayItems;
     QVariantList mDataItems;
 };
@@ -56,8 +91,27 @@ class FORMGENWIDGETS_EXPORT FormGenBagModel : public QAbstractListModel {
 public:
     typedef QPair<QString, QVariant> DataElement;
     typedef sorted_sequence::function_compare<DataElement> Compare;
+    typedef FormGenListModel::DisplayFunction DisplayFunction;
+    typedef FormGenListModel::RowPredicate RowPredicate;
+
+    /// Container keeping the sorted rows.
+    enum Storage {
+        VectorStorage, ///< contiguous; inserting, moving and removing rows shifts the rows behind
+        TreeStorage    ///< order statistic B+tree; row access, insert, move and remove in O(log n)
+    };
+
+    enum SortDirection {
+        Ascending, Descending
+    };
+
+    /// A sub value of the row data by FormGenPath string, e.g. "i" or "a/b", to sort by.
+    struct SortKey {
+        QString path;
+        SortDirection direction;
+    };
 
     FormGenBagModel(QObject * parent = 0);
+    ~FormGenBagModel();
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     int rowCount(const QModelIndex &parent) const override;
@@ -65,12 +119,325 @@ public:
     int insertRow(const QString &display, const QVariant &data);
     int editRow(int row, const QString &newDisplay, const QVariant &newData);
     void removeRow(int row);
+    using QAbstractListModel::removeRows;
+    /// See FormGenListModel::removeRows.
+    void removeRows(const QList<int> &rows);
+    /// See FormGenListModel::removeIf.
+    int removeIf(const RowPredicate &matches);
     void clear();
 
+    /**
+     * Adds the pre-rendered rows at their sorted positions, sorting the batch once. Emits
+     * one range insert per run of rows that end up next to each other (a single one e.g.
+     * when the bag was empty), or a single model reset if the rows are spread too widely.
+     */
+    void appendRows(const QStringList &displays, const QVariantList &data);
+    /// Replaces all rows with a single model reset, sorting them once.
+    void resetRows(const QStringList &displays, const QVariantList &data);
+
+    /// Like FormGenListModel::reconcile, but the rows are matched as a multiset: only the
+    /// rows missing from newData are removed and only the additional values are inserted.
+    bool reconcile(const QVariantList &newData, const DisplayFunction &display);
+    /**
+     * Like resetRows, but keeps the rows that stay, like reconcile: the new rows are sorted
+     * once and matched against the current ones in a single pass over both, see
+     * sorted_sequence::adaptor::differenceRanges. Returns whether any row changed.
+     */
+    bool replaceRows(const QStringList &displays, const QVariantList &data);
+
     void setCompareOperator(const Compare &comparison);
+    /**
+     * Like setCompareOperator, but keeps the concrete type of lessThan (a functor on two
+     * DataElements), so the comparisons are inlined into the sort and search loops
+     * instead of going through a std::function call each.
+     */
+    template< class LessThan >
+    void setCompareFunctor(const LessThan &lessThan);
+    /**
+     * Sorts the rows by the given sub values, the first key deciding first. The keys are
+     * extracted once per row: numbers, dates and times compare by value, strings by
+     * collation; rows missing a key sort before the others (after them if descending).
+     */
+    void setSortKeys(const QVector<SortKey> &keys);
+
+    Storage storage() const;
+    /// Moves the rows into the given container, their order stays the same.
+    void setStorage(Storage storage);
+
+    bool parallelSorting() const;
+    /**
+     * Resort the rows on all cores when the order changes (setCompareOperator,
+     * setSortKeys, setCompareFunctor), see sorted_sequence::parallel_stable_sort_algorithm.
+     * A custom comparison must then be safe to call concurrently. Off by default.
+     */
+    void setParallelSorting(bool enabled);
+
+private:
+    typedef std::function<void (int first, int last)> RunFunction;
+
+    // The sorted rows, independent of the container type and the comparison.
+    class Items {
+    public:
+        virtual ~Items() {}
+
+        virtual int size() const = 0;
+        virtual const DataElement &at(int row) const = 0;
+        /// Gallops outwards from positionHint if it is a valid row, see sorted_sequence::adaptor.
+        virtual int insertPosition(const DataElement &element, int positionHint) const = 0;
+        virtual void insert(const DataElement &element, int row) = 0;
+        virtual void change(int row, const DataElement &element, int newRowBeforeRemove) = 0;
+        virtual void removeRange(int begin, int end) = 0;
+        /// Removes the ascending [first, last) runs of rows with one pass over all rows.
+        virtual void removeRuns(const QVector<QPair<int, int> > &runs) = 0;
+        virtual void clear() = 0;
+        /// Sorts elements in, see mergeRuns.
+        virtual void merge(const QVector<DataElement> &elements, const RunFunction &aboutToInsert,
+                           const RunFunction &inserted) = 0;
+        /// Matches elements against the rows as a multiset, reporting the [first, last) runs of
+        /// rows missing from elements and the elements missing from the rows.
+        virtual void diff(const QVector<DataElement> &elements, QVector<QPair<int, int> > *missingRows,
+                          QVector<DataElement> *additional) const = 0;
+        /// Removes all rows, returning them in their order.
+        virtual QVector<DataElement> takeAll() = 0;
+        /// Moves all rows and the order into a new Items of the given storage.
+        virtual Items *moveTo(Storage storage) = 0;
+    };
+
+    template< class Container > class ItemsImpl;
+    template< class LessThan, class Container > class FunctorItems;
+
+    static Items *sortedItems(Storage storage, const Compare *comparison, const QVector<SortKey> &keys,
+                              const QVector<DataElement> &elements, QHash<int, int> *oldToNew, bool parallel);
+    // sorts rows in place, reporting the new rows of the ones in oldToNew (if given)
+    template< class Container, class LessThan >
+    static void sortRows(Container &rows, const LessThan &lessThan, QHash<int, int> *oldToNew, bool parallel);
+    // rows are built and sorted flat, trees are bulk loaded from and emptied into vectors in O(n)
+    template< class T >
+    static void assignRows(std::vector<T> &container, std::vector<T> &&rows);
+    template< class Container, class T >
+    static void assignRows(Container &container, std::vector<T> &&rows);
+    template< class T >
+    static std::vector<T> flatRows(std::vector<T> &&container);
+    template< class T, std::size_t NodeBytes >
+    static std::vector<T> flatRows(sorted_sequence::order_statistic_tree<T, NodeBytes> &&container);
+    template< class Sequence >
+    static void mergeRuns(Sequence &sequence, std::vector<typename Sequence::value_type> &batch,
+                          const RunFunction &aboutToInsert, const RunFunction &inserted);
+    static bool signalsRunsSeparately(const QVector<QPair<int, int> > &runs, int rowCount);
+
+    void mergeRows(const QVector<DataElement> &elements);
+    void removeRuns(const QVector<QPair<int, int> > &runs);
+    void replaceRuns(const QVector<QPair<int, int> > &removedRuns, const QVector<DataElement> &added);
+
+    void reorderRows(const std::function<Items *(QHash<int, int> *)> &resort);
+    static QVector<DataElement> dataElements(const QStringList &displays, const QVariantList &data);
+
+    Storage mStorage;
+    bool mParallelSorting;
+    Items *mItems;
+};
+
+
+template< class LessThan, class Container >
+class FormGenBagModel::FunctorItems : public FormGenBagModel::Items {
+public:
+    typedef sorted_sequence::adaptor< Container, LessThan > Sequence;
+
+    FunctorItems(const LessThan &lessThan, const QVector<DataElement> &elements, QHash<int, int> *oldToNew,
+                 bool parallel)
+        : mSequence(sorted_sequence::presorted, sortedRows(lessThan, elements, oldToNew, parallel), lessThan)
+    {
+    }
+
+    template< class OtherContainer >
+    explicit FunctorItems(FunctorItems<LessThan, OtherContainer> &other)
+        : mSequence(sorted_sequence::presorted, containerOf(flatRows(other.mSequence.takeContainer())),
+                    other.mSequence.compareOperator())
+    {
+    }
+
+    int size() const override { return int(mSequence.size()); }
+    const DataElement &at(int row) const override { return mSequence.at(row); }
+
+    int insertPosition(const DataElement &element, int positionHint) const override
+    {
+        return int(mSequence.insertPosition(element, sorted_sequence::InsertLast, positionHint));
+    }
+
+    void insert(const DataElement &element, int row) override { mSequence.insert(element, sorted_sequence::InsertLast, row); }
+
+    void change(int row, const DataElement &element, int newRowBeforeRemove) override
+    {
+        mSequence.change(row, element, sorted_sequence::InsertLast, newRowBeforeRemove);
+    }
+
+    void removeRange(int begin, int end) override { mSequence.removeRange(begin, end); }
+
+    void removeRuns(const QVector<QPair<int, int> > &runs) override
+    {
+        typename Sequence::index_ranges ranges;
+        ranges.reserve(runs.size());
+        for( const auto &run : runs )
+            ranges.push_back(std::make_pair(typename Sequence::index(run.first), typename Sequence::index(run.second)));
+        mSequence.removeRanges(ranges);
+    }
+
+    void clear() override { mSequence.clear(); }
+
+    void merge(const QVector<DataElement> &elements, const RunFunction &aboutToInsert,
+               const RunFunction &inserted) override
+    {
+        std::vector<DataElement> batch(elements.cbegin(), elements.cend());
+        mergeRuns(mSequence, batch, aboutToInsert, inserted);
+    }
+
+    void diff(const QVector<DataElement> &elements, QVector<QPair<int, int> > *missingRows,
+              QVector<DataElement> *additional) const override
+    {
+        const Sequence other(sorted_sequence::presorted, sortedRows(mSequence.compareOperator(), elements, nullptr, false),
+                             mSequence.compareOperator());
+        for( const auto &run : mSequence.differenceRanges(other) )
+            missingRows->append(qMakePair(int(run.first), int(run.second)));
+        for( const auto &run : other.differenceRanges(mSequence) ) {
+            for( auto i = run.first; i < run.second; ++i )
+                additional->append(other.at(i));
+        }
+    }
+
+    QVector<DataElement> takeAll() override
+    {
+        std::vector<DataElement> rows = flatRows(mSequence.takeContainer());
+        QVector<DataElement> elements;
+        elements.reserve(int(rows.size()));
+        for( auto &row : rows )
+            elements.append(std::move(row));
+        return elements;
+    }
+
+    Items *moveTo(Storage storage) override
+    {
+        if( storage == TreeStorage )
+            return new FunctorItems< LessThan, sorted_sequence::order_statistic_tree<DataElement> >(*this);
+        return new FunctorItems< LessThan, std::vector<DataElement> >(*this);
+    }
 
 private:
-    sorted_sequence::adaptor< QVector<DataElement>, Compare > mItems;
+    template< class, class > friend class FunctorItems;
+
+    // LessThan may be a lambda, which cannot be assigned, so the rows are sorted up front
+    static Container sortedRows(const LessThan &lessThan, const QVector<DataElement> &elements,
+                                QHash<int, int> *oldToNew, bool parallel)
+    {
+        std::vector<DataElement> rows(elements.cbegin(), elements.cend());
+        sortRows(rows, lessThan, oldToNew, parallel);
+        return containerOf(std::move(rows));
+    }
+
+    static Container containerOf(std::vector<DataElement> &&rows)
+    {
+        Container container;
+        assignRows(container, std::move(rows));
+        return container;
+    }
+
+    Sequence mSequence;
 };
 
+template< class LessThan >
+void FormGenBagModel::setCompareFunctor(const LessThan &lessThan)
+{
+    reorderRows([this, &lessThan] (QHash<int, int> *oldToNew) -> Items * {
+        if( mStorage == TreeStorage )
+            return new FunctorItems< LessThan, sorted_sequence::order_statistic_tree<DataElement> >(lessThan, mItems->takeAll(),
+                                                                                                    oldToNew, mParallelSorting);
+        return new FunctorItems< LessThan, std::vector<DataElement> >(lessThan, mItems->takeAll(), oldToNew, mParallelSorting);
+    });
+}
+
+template< class Container, class LessThan >
+void FormGenBagModel::sortRows(Container &rows, const LessThan &lessThan, QHash<int, int> *oldToNew, bool parallel)
+{
+    typedef sorted_sequence::default_sort_algorithm Sequential;
+    typedef sorted_sequence::parallel_stable_sort_algorithm<> Parallel;
+
+    if( oldToNew ) {
+        if( parallel )
+            sorted_sequence::sort_get_reorder_map<Parallel>(rows, lessThan, oldToNew);
+        else
+            sorted_sequence::sort_get_reorder_map<Sequential>(rows, lessThan, oldToNew);
+    } else {
+        if( parallel )
+            sorted_sequence::sort_container<Parallel>(rows, lessThan);
+        else
+            sorted_sequence::sort_container<Sequential>(rows, lessThan);
+    }
+}
+
+/**
+ * Sorts batch and inserts it into sequence. Without aboutToInsert, it is merged in at once.
+ * Otherwise the batch is inserted run by run, a run being values that end up next to each
+ * other, calling aboutToInsert(first, last) and inserted(first, last) around each with the
+ * rows [first, last) of the run. If the runs would shift too many rows for that, the batch is
+ * merged in at once between aboutToInsert(-1, -1) and inserted(-1, -1).
+ */
+template< class T >
+void FormGenBagModel::assignRows(std::vector<T> &container, std::vector<T> &&rows)
+{
+    container = std::move(rows);
+}
+
+template< class Container, class T >
+void FormGenBagModel::assignRows(Container &container, std::vector<T> &&rows)
+{
+    container.assign(std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+}
+
+template< class T >
+std::vector<T> FormGenBagModel::flatRows(std::vector<T> &&container)
+{
+    return std::move(container);
+}
+
+template< class T, std::size_t NodeBytes >
+std::vector<T> FormGenBagModel::flatRows(sorted_sequence::order_statistic_tree<T, NodeBytes> &&container)
+{
+    return container.take_all();
+}
+
+template< class Sequence >
+void FormGenBagModel::mergeRuns(Sequence &sequence, std::vector<typename Sequence::value_type> &batch,
+                                const RunFunction &aboutToInsert, const RunFunction &inserted)
+{
+    if( batch.empty() )
+        return;
+
+    if( ! aboutToInsert ) {
+        sequence.insertRange(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        return;
+    }
+
+    std::stable_sort(batch.begin(), batch.end(), sequence.compareOperator());
+    const auto ranges = sequence.insertedRanges(batch.cbegin(), batch.cend());
+    QVector<QPair<int, int> > runs;
+    runs.reserve(int(ranges.size()));
+    for( const auto &range : ranges )
+        runs.append(qMakePair(int(range.first), int(range.second)));
+
+    if( ! signalsRunsSeparately(runs, int(sequence.size() + batch.size())) ) {
+        aboutToInsert(-1, -1);
+        sequence.insertRange(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        inserted(-1, -1);
+        return;
+    }
+
+    auto runBegin = batch.begin();
+    for( const auto &run : runs ) {
+        const auto runEnd = runBegin + (run.second - run.first);
+        aboutToInsert(run.first, run.second);
+        sequence.insertRange(std::make_move_iterator(runBegin), std::make_move_iterator(runEnd));
+        inserted(run.first, run.second);
+        runBegin = runEnd;
+    }
+}
+
 #endif // FORMGENWIDGETS_QT_COMPOSITIONMODELS_H
@@ -0,0 +1,310 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "formgencompositionschema.h"
+#include "formgenschemabase_p.h"
+
+#include <QRegularExpression>
+
+
+FormGenTaggedCompositionNode::FormGenTaggedCompositionNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+FormGenTaggedCompositionNode::~FormGenTaggedCompositionNode()
+{
+    for( const auto &elm : mElements ) {
+        if( elm.owned )
+            delete elm.node;
+    }
+}
+
+bool FormGenTaggedCompositionNode::addElement(const QString &tag, FormGenSchemaNode *node)
+{
+    if( ! addElement(tag, node, true) ) {
+        delete node;
+        return false;
+    }
+    return true;
+}
+
+const FormGenSchemaNode *FormGenTaggedCompositionNode::element(const QString &tag) const
+{
+    const int idx = indexOf(tag);
+    if( idx < 0 )
+        return nullptr;
+
+    return mElements.at(idx).node;
+}
+
+int FormGenTaggedCompositionNode::elementCount() const
+{
+    return mElements.size();
+}
+
+int FormGenTaggedCompositionNode::indexOf(const QString &tag) const
+{
+    QHash<QString, int>::const_iterator it = mTagIndexMap.find(tag);
+    if( it == mTagIndexMap.cend() )
+        return -1;
+
+    return it.value();
+}
+
+const QString &FormGenTaggedCompositionNode::tagAt(int idx) const
+{
+    return mElements.at(idx).tag;
+}
+
+const FormGenSchemaNode *FormGenTaggedCompositionNode::elementAt(int idx) const
+{
+    return mElements.at(idx).node;
+}
+
+bool FormGenTaggedCompositionNode::addElement(const QString &tag, const FormGenSchemaNode *node, bool owned)
+{
+    if( ! tagPattern()->match(tag).hasMatch() ) {
+        qWarning("FormGenTaggedCompositionNode::addElement: tag must be nonempty and without / and control chars.");
+        return false;
+    }
+
+    if( mTagIndexMap.contains(tag) ) {
+        qWarning("FormGenTaggedCompositionNode::addElement: duplicated tag %s.", qPrintable(tag));
+        return false;
+    }
+
+    Q_ASSERT(node);
+
+    mElements.append(ChildNode(tag, node, owned));
+    mTagIndexMap[tag] = mElements.size() - 1;
+    return true;
+}
+
+
+FormGenRecordNode::FormGenRecordNode(FormGenSchemaBase::ElementType type)
+    : FormGenTaggedCompositionNode(type)
+{
+}
+
+QVariant FormGenRecordNode::defaultValue() const
+{
+    QVariantHash map;
+    for( int i = 0; i < elementCount(); ++i )
+        map[tagAt(i)] = elementAt(i)->defaultValue();
+    return map;
+}
+
+FormGenAcceptResult FormGenRecordNode::acceptsValueImpl(const QVariant &val) const
+{
+    QStringList valueStringList;
+    valueStringList.reserve(elementCount());
+    FormGenAcceptResult result = checkElements(val, &FormGenSchemaNode::acceptsValue, &valueStringList);
+    if( result.acceptable )
+        result.valueString = objectString(valueStringList);
+    return result;
+}
+
+FormGenAcceptResult FormGenRecordNode::validateImpl(const QVariant &val) const
+{
+    return checkElements(val, &FormGenSchemaNode::validate, nullptr);
+}
+
+// runs check on the value of every element, collecting the key value strings in valueStrings if given
+FormGenAcceptResult FormGenRecordNode::checkElements(const QVariant &val, Check check, QStringList *valueStrings) const
+{
+    if( variantType(val) != QMetaType::QVariantHash )
+        return FormGenAcceptResult::reject({}, val);
+
+    // no copies of the hash and no tag sets: unknown tags are detected by
+    // comparing the number of matched tags with the hash size
+    const QVariantHash &hash = formGenBorrowedHash(val);
+    static const QVariant missing;
+    int matchedTags = 0;
+
+    for( int i = 0; i < elementCount(); ++i ) {
+        const QString &tag = tagAt(i);
+        const auto it = hash.constFind(tag);
+        const QVariant *childVal = &missing;
+        if( it != hash.cend() ) {
+            childVal = &it.value();
+            ++matchedTags;
+        }
+
+        auto elementResult = (elementAt(i)->*check)(*childVal);
+        if( ! elementResult.acceptable )
+            return FormGenAcceptResult::reject(formGenJoinedPath(tag, elementResult.path), elementResult.value);
+        if( valueStrings )
+            valueStrings->append(keyStringValuePair(tag, elementResult.valueString));
+    }
+
+    if( matchedTags != hash.size() )
+        return rejectUnknownTag(hash);
+
+    return FormGenAcceptResult::accept(val, {});
+}
+
+FormGenAcceptResult FormGenRecordNode::rejectUnknownTag(const QVariantHash &hash) const
+{
+    for( auto it = hash.cbegin(); it != hash.cend(); ++it ) {
+        if( indexOf(it.key()) < 0 )
+            return FormGenAcceptResult::reject(it.key(), it.value());
+    }
+
+    Q_UNREACHABLE();
+    return FormGenAcceptResult::reject({}, hash);
+}
+
+
+FormGenChoiceNode::FormGenChoiceNode(FormGenSchemaBase::ElementType type)
+    : FormGenTaggedCompositionNode(type)
+{
+}
+
+QVariant FormGenChoiceNode::defaultValue() const
+{
+    QVariantHash map;
+
+    if( elementCount() > 0)
+        map[tagAt(0)] = elementAt(0)->defaultValue();
+
+    return map;
+}
+
+FormGenAcceptResult FormGenChoiceNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( ! result.acceptable )
+        return result;
+
+    const QVariantHash &hash = formGenBorrowedHash(val);
+    const QString &tag = hash.cbegin().key();
+    auto elementAccepts = elementAt(indexOf(tag))->acceptsValue(hash.cbegin().value());
+
+    QString keyValue = keyStringValuePair(tag, elementAccepts.valueString);
+    result.valueString = objectString(QStringList({keyValue}));
+    return result;
+}
+
+FormGenAcceptResult FormGenChoiceNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) != QMetaType::QVariantHash )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QVariantHash &hash = formGenBorrowedHash(val);
+    if( hash.size() != 1 )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QString &tag = hash.cbegin().key();
+    const int idx = indexOf(tag);
+    if( idx < 0 )
+        return FormGenAcceptResult::reject({}, val);
+
+    auto elementValid = elementAt(idx)->validate(hash.cbegin().value());
+    if( ! elementValid.acceptable )
+        return FormGenAcceptResult::reject(formGenJoinedPath(tag, elementValid.path), elementValid.value);
+
+    return FormGenAcceptResult::accept(val, {});
+}
+
+
+FormGenListBagNode::FormGenListBagNode(FormGenListBagNode::Mode mode, FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+    , mMode(mode)
+    , mElement(nullptr)
+    , mElementOwned(false)
+{
+}
+
+FormGenListBagNode::~FormGenListBagNode()
+{
+    if( mElementOwned )
+        delete mElement;
+}
+
+void FormGenListBagNode::setContentElement(FormGenSchemaNode *node)
+{
+    setContentElement(node, true);
+}
+
+const FormGenSchemaNode *FormGenListBagNode::contentElement() const
+{
+    return mElement;
+}
+
+FormGenListBagNode::Mode FormGenListBagNode::mode() const
+{
+    return mMode;
+}
+
+QVariant FormGenListBagNode::defaultValue() const
+{
+    return QVariantList();
+}
+
+FormGenAcceptResult FormGenListBagNode::acceptsValueImpl(const QVariant &val) const
+{
+    QStringList valueStrings;
+    FormGenAcceptResult result = checkElements(val, &FormGenSchemaNode::acceptsValue, &valueStrings);
+    if( result.acceptable )
+        result.valueString = joinedValueStringList(valueStrings);
+    return result;
+}
+
+FormGenAcceptResult FormGenListBagNode::validateImpl(const QVariant &val) const
+{
+    return checkElements(val, &FormGenSchemaNode::validate, nullptr);
+}
+
+// runs check on every item, collecting their value strings in valueStrings if given
+FormGenAcceptResult FormGenListBagNode::checkElements(const QVariant &val, Check check, QStringList *valueStrings) const
+{
+    if( variantType(val) != QMetaType::QVariantList )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QVariantList &list = formGenBorrowedList(val);
+
+    if( list.size() > 0 && mElement == nullptr )
+        return FormGenAcceptResult::reject({}, val);
+
+    if( valueStrings )
+        valueStrings->reserve(list.size());
+
+    for( int i = 0; i < list.size(); ++i ) {
+        auto elementResult = (mElement->*check)(list.at(i));
+        if( ! elementResult.acceptable )
+            return FormGenAcceptResult::reject(formGenJoinedPath(QString::number(i), elementResult.path),
+                                               elementResult.value);
+        if( valueStrings )
+            valueStrings->append(elementResult.valueString);
+    }
+
+    return FormGenAcceptResult::accept(val, {});
+}
+
+void FormGenListBagNode::setContentElement(const FormGenSchemaNode *node, bool owned)
+{
+    if( node == mElement )
+        return;
+
+    if( mElementOwned )
+        delete mElement;
+
+    mElement = node;
+    mElementOwned = owned && node;
+}
@@ -0,0 +1,133 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMGENWIDGETS_QT_COMPOSITIONSCHEMA_H
+#define FORMGENWIDGETS_QT_COMPOSITIONSCHEMA_H
+
+#include "formgenschemabase.h"
+
+#include <QHash>
+#include <QVector>
+
+#include "formgenwidgets_global.h"
+
+
+/**
+ * Base for the composition nodes: an ordered list of tagged child nodes.
+ * Children added through the public API are owned by the composition; the
+ * composition widgets reference the nodes of their child widgets instead.
+ */
+class FORMGENWIDGETS_CORE_EXPORT FormGenTaggedCompositionNode : public FormGenSchemaNode {
+public:
+    explicit FormGenTaggedCompositionNode(ElementType type = Required);
+    ~FormGenTaggedCompositionNode() override;
+
+    /// Takes ownership of node, returns false (and deletes node) if the tag is invalid or taken.
+    bool addElement(const QString & tag, FormGenSchemaNode * node);
+    const FormGenSchemaNode *element(const QString & tag) const;
+
+    int elementCount() const;
+    int indexOf(const QString & tag) const;
+    const QString &tagAt(int idx) const;
+    const FormGenSchemaNode *elementAt(int idx) const;
+
+protected:
+    bool addElement(const QString & tag, const FormGenSchemaNode * node, bool owned);
+
+private:
+    struct ChildNode {
+        ChildNode(const QString &_tag = QString(), const FormGenSchemaNode *_node = nullptr, bool _owned = false)
+            : tag(_tag)
+            , node(_node)
+            , owned(_owned)
+        {}
+
+        QString tag;
+        const FormGenSchemaNode *node;
+        bool owned;
+    };
+
+    QVector<ChildNode> mElements;
+    QHash<QString, int> mTagIndexMap;
+
+    friend class FormGenRecordComposition;
+    friend class FormGenChoiceComposition;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenRecordNode : public FormGenTaggedCompositionNode {
+public:
+    explicit FormGenRecordNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+
+private:
+    FormGenAcceptResult checkElements(const QVariant &val, Check check, QStringList *valueStrings) const;
+    FormGenAcceptResult rejectUnknownTag(const QVariantHash &hash) const;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenChoiceNode : public FormGenTaggedCompositionNode {
+public:
+    explicit FormGenChoiceNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenListBagNode : public FormGenSchemaNode {
+public:
+    enum Mode {
+        ListMode, BagMode
+    };
+
+    explicit FormGenListBagNode(Mode mode, ElementType type = Required);
+    ~FormGenListBagNode() override;
+
+    /// Takes ownership of node (and deletes a previously set content node).
+    void setContentElement(FormGenSchemaNode * node);
+    const FormGenSchemaNode *contentElement() const;
+
+    Mode mode() const;
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+
+private:
+    FormGenAcceptResult checkElements(const QVariant &val, Check check, QStringList *valueStrings) const;
+    void setContentElement(const FormGenSchemaNode * node, bool owned);
+
+    Mode mMode;
+    const FormGenSchemaNode *mElement;
+    bool mElementOwned;
+
+    friend class FormGenListBagComposition;
+};
+
+#endif // FORMGENWIDGETS_QT_COMPOSITIONSCHEMA_H
@@ -18,6 +18,7 @@
 
 #include "formgencompositionwidgets.h"
 #include "formgencompositionwidgets_p.h"
+#include "formgenschemabase_p.h"
 
 #include "ui_formgenlistbaghead.h"
 
@@ -34,10 +35,30 @@
 static const int s_frameSubContentMargin = 8;
 
 
+// Whether setting val on an element that holds current leaves it as it is: the types must match,
+// as QVariant::operator== converts between them, and containers must share their data, so
+// changed nested values are left to the element instead of compared deeply here.
+static bool isUnchangedValue(const QVariant &val, const QVariant &current)
+{
+    if( val.userType() != current.userType() )
+        return false;
+
+    switch( val.userType() ) {
+    case QMetaType::QVariantHash:
+        return formGenBorrowedHash(val).isSharedWith(formGenBorrowedHash(current));
+    case QMetaType::QVariantList:
+        return formGenBorrowedList(val).isSharedWith(formGenBorrowedList(current));
+    default:
+        return val == current;
+    }
+}
+
+
 FormGenRecordComposition::FormGenRecordComposition(FormGenElement::ElementType type, QWidget *parent)
     : FormGenFramedBase(type, parent)
     , mLayout(new QFormLayout)
     , mUpdating(NotUpdatingState)
+    , mSchema(type)
 {
     mLayout->setContentsMargins(0, 0, 0, 0);
     frameWidget()->setLayout(mLayout);
@@ -47,20 +68,15 @@ void FormGenRecordComposition::addElement(const QString &tag,
                                           FormGenElement *element,
                                           const QString &label)
 {
-    if( ! tagPattern()->match(tag).hasMatch() ) {
-        qWarning("FormGenRecordComposition::addElement: tag must be nonempty and without / and control chars.");
+    if( ! mSchema.addElement(tag, element->schemaNode(), false) )
         return;
-    }
-
-    if( mTagIndexMap.contains(tag) ) {
-        qWarning("FormGenRecordComposition::addElement: duplicated tag %s.", qPrintable(tag));
-        return;
-    }
 
     mElements.append(CompositionElement(tag, element));
-    mTagIndexMap[tag] = mElements.size() - 1;
-    connect(element, &FormGenElement::valueChanged,
-            this, &FormGenRecordComposition::childValueChanged);
+    connect(element, &FormGenElement::valueChangedAt,
+            this, [this, tag] (const FormGenPath &path, const QVariant &newSubValue)
+    {
+        childValueChanged(tag, path, newSubValue);
+    });
 
     if( element->frameWidget() ) {
         element->frameWidget()->setTitle(label.isEmpty() ? tag : label);
@@ -69,24 +85,21 @@ void FormGenRecordComposition::addElement(const QString &tag,
         mLayout->addRow(label.isEmpty() ? tag : label, element);
     }
 
-    emit valueChanged();
+    notifyValueChanged();
 }
 
 FormGenElement *FormGenRecordComposition::element(const QString &tag) const
 {
-    QHash<QString, int>::const_iterator it = mTagIndexMap.find(tag);
-    if( it == mTagIndexMap.cend() )
+    const int idx = mSchema.indexOf(tag);
+    if( idx < 0 )
         return nullptr;
 
-    return mElements.at(it.value()).element;
+    return mElements.at(idx).element;
 }
 
-QVariant FormGenRecordComposition::defaultValue() const
+const FormGenSchemaNode *FormGenRecordComposition::schemaNode() const
 {
-    QVariantHash map;
-    for( const auto &elm : mElements )
-        map[elm.tag] = elm.element->defaultValue();
-    return map;
+    return &mSchema;
 }
 
 QVariant FormGenRecordComposition::valueImpl() const
@@ -107,55 +120,65 @@ QString FormGenRecordComposition::valueStringImpl() const
     return objectString(list);
 }
 
-FormGenAcceptResult FormGenRecordComposition::acceptsValueImpl(const QVariant &val) const
+void FormGenRecordComposition::writeValueStringImpl(FormGenWriter &writer) const
 {
-    if( variantType(val) != QMetaType::QVariantHash )
-        return FormGenAcceptResult::reject({}, val);
-
-    QVariantHash hash = val.toHash();
-    QStringList valueStringList;
-    QSet<QString> processedTags;
-
+    writer.beginObject();
     for( const auto &elm : mElements ) {
-        auto elementAccepts = elm.element->acceptsValue(hash.value(elm.tag));
-        if( ! elementAccepts.acceptable ) {
-            QString path = elm.tag;
-            if( ! elementAccepts.path.isEmpty() )
-                path += QString("/%1").arg(elementAccepts.path);
-            return FormGenAcceptResult::reject(path, elementAccepts.value);
-        }
-        valueStringList.append(FormGenElement::keyStringValuePair(elm.tag, elementAccepts.valueString));
-        processedTags.insert(elm.tag);
+        writer.writeKey(elm.tag);
+        elm.element->writeValueString(writer);
     }
-
-    QSet<QString> remainingTags = hash.keys().toSet() - processedTags;
-    if( ! remainingTags.isEmpty() )
-        return FormGenAcceptResult::reject(*remainingTags.cbegin(),
-                                           hash.value(*remainingTags.cbegin()));
-
-    return FormGenAcceptResult::accept(val, FormGenElement::objectString(valueStringList));
+    writer.endObject();
 }
 
 void FormGenRecordComposition::setVaidatedValueImpl(const QVariant &val)
 {
     mUpdating = UpdatingState;
 
+    // only touch the children whose value changed; an unchanged sub value that is
+    // still shared with a value() snapshot is recognized in constant time
     const QVariantHash map = val.toHash();
-    for( auto it = map.cbegin(); it != map.cend(); ++it )
-        mElements.at(mTagIndexMap.value(it.key())).element->setValidatedValue(it.value());
+    for( auto it = map.cbegin(); it != map.cend(); ++it ) {
+        FormGenElement *element = mElements.at(mSchema.indexOf(it.key())).element;
+        if( isUnchangedValue(it.value(), element->value()) )
+            continue;
+        element->setValidatedValue(it.value());
+    }
 
     if( mUpdating == UpdatingWithChangeState )
-        emit valueChanged();
+        notifyValueChanged();
 
     mUpdating = NotUpdatingState;
 }
 
-void FormGenRecordComposition::childValueChanged()
+QVariant FormGenRecordComposition::valueAtImpl(const FormGenPath &path) const
 {
-    if( mUpdating == NotUpdatingState )
-        emit valueChanged();
-    else
+    const int idx = mSchema.indexOf(path.at(0));
+    if( idx < 0 )
+        return {};
+
+    return mElements.at(idx).element->valueAt(path.mid(1));
+}
+
+bool FormGenRecordComposition::setValueAtImpl(const FormGenPath &path, const QVariant &val)
+{
+    const int idx = mSchema.indexOf(path.at(0));
+    if( idx < 0 )
+        return false;
+
+    return mElements.at(idx).element->setValueAt(path.mid(1), val);
+}
+
+void FormGenRecordComposition::childValueChanged(const QString &tag, const FormGenPath &path, const QVariant &newSubValue)
+{
+    if( mUpdating != NotUpdatingState ) {
         mUpdating = UpdatingWithChangeState;
+        return;
+    }
+
+    if( isValueSet() )
+        emitSubValueChanged(path.prepended(tag), newSubValue);
+    else
+        notifyValueChanged();
 }
 
 
@@ -164,6 +187,7 @@ FormGenChoiceComposition::FormGenChoiceComposition(FormGenElement::ElementType t
     , mComboBox(new QComboBox)
     , mElementContainer(new QWidget)
     , mElementLayout(new QStackedLayout)
+    , mSchema(type)
 {
     switch( style ) {
     case ComboBoxStyle:
@@ -177,7 +201,7 @@ FormGenChoiceComposition::FormGenChoiceComposition(FormGenElement::ElementType t
     }
 
     connect(mContainer, &FormGenChoiceCompositionContainer::currentIndexChanged,
-            this, &FormGenChoiceComposition::valueChanged);
+            this, &FormGenChoiceComposition::notifyValueChanged);
 
     auto layout = new QVBoxLayout;
     layout->setContentsMargins(0, 0, 0, 0);
@@ -187,45 +211,37 @@ FormGenChoiceComposition::FormGenChoiceComposition(FormGenElement::ElementType t
 
 void FormGenChoiceComposition::addElement(const QString &tag, FormGenElement *element, const QString &label)
 {
-    if( ! tagPattern()->match(tag).hasMatch() ) {
-        qWarning("FormGenChoiceComposition::addElement: tag must be nonempty and without / and control chars.");
+    if( ! mSchema.addElement(tag, element->schemaNode(), false) )
         return;
-    }
-
-    if( mTagIndexMap.contains(tag) ) {
-        qWarning("FormGenChoiceComposition::addElement: duplicated tag %s.", qPrintable(tag));
-        return;
-    }
 
     mElements.append(CompositionElement(tag, element));
-    mTagIndexMap[tag] = mElements.size() - 1;
 
     const QString l = label.isEmpty() ? tag : label;
 
     mContainer->addElement(l, element);
 
-    connect(element, &FormGenElement::valueChanged, this, &FormGenElement::valueChanged);
+    const int idx = mElements.size() - 1;
+    connect(element, &FormGenElement::valueChangedAt,
+            this, [this, idx] (const FormGenPath &path, const QVariant &newSubValue)
+    {
+        childValueChanged(idx, path, newSubValue);
+    });
 
     mContainer->setCurrentIndex(0);
 }
 
 FormGenElement *FormGenChoiceComposition::element(const QString &tag) const
 {
-    QHash<QString, int>::const_iterator it = mTagIndexMap.find(tag);
-    if( it == mTagIndexMap.cend() )
+    const int idx = mSchema.indexOf(tag);
+    if( idx < 0 )
         return nullptr;
 
-    return mElements.at(it.value()).element;
+    return mElements.at(idx).element;
 }
 
-QVariant FormGenChoiceComposition::defaultValue() const
+const FormGenSchemaNode *FormGenChoiceComposition::schemaNode() const
 {
-    QVariantHash map;
-
-    if( mElements.size() > 0)
-        map[mElements.first().tag] = mElements.first().element->defaultValue();
-
-    return map;
+    return &mSchema;
 }
 
 QVariant FormGenChoiceComposition::valueImpl() const
@@ -253,29 +269,16 @@ QString FormGenChoiceComposition::valueStringImpl() const
     return objectString(QStringList({keyValue}));
 }
 
-FormGenAcceptResult FormGenChoiceComposition::acceptsValueImpl(const QVariant &val) const
+void FormGenChoiceComposition::writeValueStringImpl(FormGenWriter &writer) const
 {
-    if( variantType(val) != QMetaType::QVariantHash )
-        return FormGenAcceptResult::reject({}, val);
-
-    QVariantHash hash = val.toHash();
-    if( hash.size() != 1 )
-        return FormGenAcceptResult::reject({}, hash);
-
-    auto it = mTagIndexMap.find(hash.cbegin().key());
-    if( it == mTagIndexMap.cend() )
-        return FormGenAcceptResult::reject({}, hash);
+    const int idx = mContainer->currentIndex();
 
-    auto elementAccepts = mElements.at(it.value()).element->acceptsValue(hash.cbegin().value());
-    if( ! elementAccepts.acceptable ) {
-        QString path = it.key();
-        if( ! elementAccepts.path.isEmpty() )
-            path += QString("/%1").arg(elementAccepts.path);
-        return FormGenAcceptResult::reject(path, elementAccepts.value);
+    writer.beginObject();
+    if( idx >= 0 ) {
+        writer.writeKey(mElements.at(idx).tag);
+        mElements.at(idx).element->writeValueString(writer);
     }
-
-    QString keyValue = FormGenElement::keyStringValuePair(it.key(), elementAccepts.valueString);
-    return FormGenAcceptResult::accept(val, FormGenElement::objectString(QStringList({keyValue})));
+    writer.endObject();
 }
 
 void FormGenChoiceComposition::setVaidatedValueImpl(const QVariant &val)
@@ -285,11 +288,11 @@ void FormGenChoiceComposition::setVaidatedValueImpl(const QVariant &val)
 
     if( variantType(val) == QMetaType::QVariantMap ) {
         auto map = val.toMap();
-        idx = mTagIndexMap.value(map.cbegin().key());
+        idx = mSchema.indexOf(map.cbegin().key());
         choiceVal = map.cbegin().value();
     } else {
         auto map = val.toHash();
-        idx = mTagIndexMap.value(map.cbegin().key());
+        idx = mSchema.indexOf(map.cbegin().key());
         choiceVal = map.cbegin().value();
     }
 
@@ -297,6 +300,45 @@ void FormGenChoiceComposition::setVaidatedValueImpl(const QVariant &val)
     mElements.at(idx).element->setValidatedValue(choiceVal);
 }
 
+QVariant FormGenChoiceComposition::valueAtImpl(const FormGenPath &path) const
+{
+    const int idx = mSchema.indexOf(path.at(0));
+    if( idx < 0 || idx != mContainer->currentIndex() )
+        return {};
+
+    return mElements.at(idx).element->valueAt(path.mid(1));
+}
+
+bool FormGenChoiceComposition::setValueAtImpl(const FormGenPath &path, const QVariant &val)
+{
+    const int idx = mSchema.indexOf(path.at(0));
+    if( idx < 0 )
+        return false;
+
+    if( idx == mContainer->currentIndex() )
+        return mElements.at(idx).element->setValueAt(path.mid(1), val);
+
+    // the value of another alternative can only be set as a whole, which selects it
+    if( path.size() > 1 )
+        return false;
+
+    QVariantHash hash;
+    hash.insert(path.at(0), val);
+    if( ! validate(hash).acceptable )
+        return false;
+
+    setValidatedValue(hash);
+    return true;
+}
+
+void FormGenChoiceComposition::childValueChanged(int idx, const FormGenPath &path, const QVariant &newSubValue)
+{
+    if( isValueSet() && idx == mContainer->currentIndex() )
+        emitSubValueChanged(path.prepended(mElements.at(idx).tag), newSubValue);
+    else
+        notifyValueChanged();
+}
+
 
 FormGenChoiceCompositionComboListContainer::FormGenChoiceCompositionComboListContainer(bool listMode, QWidget *parent)
     : FormGenChoiceCompositionContainer(parent)
@@ -459,6 +501,7 @@ FormGenListBagComposition::FormGenListBagComposition(Mode mode, FormGenElement::
     , mElement(nullptr)
     , mElementWrapper(nullptr)
     , mUpdating(false)
+    , mSchema(static_cast<FormGenListBagNode::Mode>(mode), type)
 {
     mHead->setupUi(mHeadWidget);
 
@@ -473,12 +516,12 @@ FormGenListBagComposition::FormGenListBagComposition(Mode mode, FormGenElement::
     mHead->labelPosition->setVisible(mMode == ListMode);
     mHead->spinPosition->setVisible(mMode == ListMode);
 
-    connect(model(), &QAbstractListModel::dataChanged, this, &FormGenListBagComposition::valueChanged);
-    connect(model(), &QAbstractListModel::modelReset, this, &FormGenListBagComposition::valueChanged);
-    connect(model(), &QAbstractListModel::rowsInserted, this, &FormGenListBagComposition::valueChanged);
-    connect(model(), &QAbstractListModel::rowsMoved, this, &FormGenListBagComposition::valueChanged);
-    connect(model(), &QAbstractListModel::rowsRemoved, this, &FormGenListBagComposition::valueChanged);
-    connect(model(), &QAbstractListModel::layoutChanged, this, &FormGenListBagComposition::valueChanged);
+    connect(model(), &QAbstractListModel::dataChanged, this, &FormGenListBagComposition::modelChanged);
+    connect(model(), &QAbstractListModel::modelReset, this, &FormGenListBagComposition::modelChanged);
+    connect(model(), &QAbstractListModel::rowsInserted, this, &FormGenListBagComposition::modelChanged);
+    connect(model(), &QAbstractListModel::rowsMoved, this, &FormGenListBagComposition::modelChanged);
+    connect(model(), &QAbstractListModel::rowsRemoved, this, &FormGenListBagComposition::modelChanged);
+    connect(model(), &QAbstractListModel::layoutChanged, this, &FormGenListBagComposition::modelChanged);
     connect(this, &FormGenElement::valueChanged, this, &FormGenListBagComposition::updateInputWidgets);
 
     connect(selectionModel(), &QItemSelectionModel::currentRowChanged,
@@ -506,9 +549,12 @@ void FormGenListBagComposition::setContentElement(FormGenElement *element, const
         mElementWrapper->deleteLater();
 
     mElement = element;
+    mSchema.setContentElement(mElement ? mElement->schemaNode() : nullptr, false);
 
     if( mElement ) {
-        connect(mElement, &FormGenElement::valueChanged, this, &FormGenListBagComposition::childValueChanged);
+        // the edited row follows the editor, even while an update batch holds back notifications
+        mElement->mEmitsThroughBatches = true;
+        connect(mElement, &FormGenElement::valueChangedAt, this, &FormGenListBagComposition::childValueChanged);
 
         if( mElement->frameWidget() ) {
             mElement->frameWidget()->setTitle(label);
@@ -545,9 +591,33 @@ void FormGenListBagComposition::setCompareOperator(const FormGenBagModel::Compar
     mModel.bag->setCompareOperator(comparison);
 }
 
-QVariant FormGenListBagComposition::defaultValue() const
+void FormGenListBagComposition::setSortKeys(const QVector<FormGenBagModel::SortKey> &keys)
+{
+    if( mMode == ListMode )
+        return;
+
+    mModel.bag->setSortKeys(keys);
+}
+
+void FormGenListBagComposition::setBagStorage(FormGenBagModel::Storage storage)
 {
-    return QVariantList();
+    if( mMode == ListMode )
+        return;
+
+    mModel.bag->setStorage(storage);
+}
+
+void FormGenListBagComposition::setBagParallelSorting(bool enabled)
+{
+    if( mMode == ListMode )
+        return;
+
+    mModel.bag->setParallelSorting(enabled);
+}
+
+const FormGenSchemaNode *FormGenListBagComposition::schemaNode() const
+{
+    return &mSchema;
 }
 
 QVariant FormGenListBagComposition::valueImpl() const
@@ -570,52 +640,68 @@ QString FormGenListBagComposition::valueStringImpl() const
     return joinedValueStringList(list);
 }
 
-FormGenAcceptResult FormGenListBagComposition::acceptsValueImpl(const QVariant &val) const
+void FormGenListBagComposition::writeValueStringImpl(FormGenWriter &writer) const
 {
-    if( variantType(val) != QMetaType::QVariantList )
-        return FormGenAcceptResult::reject({}, val);
+    writer.beginList();
+    for( int i = 0; i < model()->rowCount(); ++i )
+        writer.writeValue(model()->data(model()->index(i, 0), Qt::DisplayRole).toString());
+    writer.endList();
+}
 
-    const QVariantList list = val.toList();
+void FormGenListBagComposition::setVaidatedValueImpl(const QVariant &val)
+{
+    const auto list = val.toList();
 
-    if( list.size() > 0 && mElement == nullptr )
-        return FormGenAcceptResult::reject({}, val);
+    if( list.size() == 0 && model()->rowCount() == 0 )
+        return;
 
-    QStringList valueStrings;
+    // only touch the rows that differ, so views keep selection and scroll position
+    const auto display = [this] (const QVariant &v) {
+        return mElement->acceptsValue(v).valueString;
+    };
 
-    for( int i = 0; i < list.size(); ++i ) {
-        auto elementAccepts = mElement->acceptsValue(list.at(i));
-        if( ! elementAccepts.acceptable ) {
-            QString path = QString::number(i);
-            if( ! elementAccepts.path.isEmpty() )
-                path += QString("/%1").arg(elementAccepts.path);
-            return FormGenAcceptResult::reject(path, elementAccepts.value);
-        }
-        valueStrings.append(elementAccepts.valueString);
-    }
+    mUpdating = true;
+    const bool changed = mMode == ListMode ? mModel.list->reconcile(list, display)
+                                           : mModel.bag->reconcile(list, display);
+    mUpdating = false;
 
-    return FormGenAcceptResult::accept(val, joinedValueStringList(valueStrings));
+    if( changed )
+        notifyValueChanged();
 }
 
-void FormGenListBagComposition::setVaidatedValueImpl(const QVariant &val)
+QVariant FormGenListBagComposition::valueAtImpl(const FormGenPath &path) const
 {
-    const auto list = val.toList();
+    int row;
+    if( ! rowOf(path.at(0), &row) )
+        return {};
 
-    if( list.size() == 0 && model()->rowCount() == 0 )
-        return;
+    return variantAt(model()->data(model()->index(row, 0), Qt::EditRole), path.mid(1));
+}
 
-    if( mMode == ListMode ) {
-        mModel.list->clear();
-        for( const auto &v : list ) {
-            const auto elementAccepts = mElement->acceptsValue(v);
-            mModel.list->appendRow(elementAccepts.valueString, v);
-        }
-    } else {
-        mModel.bag->clear();
-        for( const auto &v : list ) {
-            const auto elementAccepts = mElement->acceptsValue(v);
-            mModel.bag->insertRow(elementAccepts.valueString, v);
-        }
-    }
+bool FormGenListBagComposition::setValueAtImpl(const FormGenPath &path, const QVariant &val)
+{
+    int row;
+    if( ! rowOf(path.at(0), &row) || mElement == nullptr )
+        return false;
+
+    const FormGenPath subPath = path.mid(1);
+    QVariant rowValue = model()->data(model()->index(row, 0), Qt::EditRole);
+    if( ! setVariantAt(rowValue, subPath, val) )
+        return false;
+
+    const auto elementAccepts = mElement->acceptsValue(rowValue);
+    if( ! elementAccepts.acceptable )
+        return false;
+
+    const bool editsCurrentRow = row == selectionModel()->currentIndex().row();
+
+    mUpdating = true;
+    editRow(row, elementAccepts.valueString, rowValue, subPath, val);
+    mUpdating = false;
+
+    if( editsCurrentRow )
+        updateInputWidgets();
+    return true;
 }
 
 void FormGenListBagComposition::updateInputWidgets()
@@ -661,7 +747,15 @@ void FormGenListBagComposition::updateInputWidgets()
     }
 }
 
-void FormGenListBagComposition::childValueChanged()
+void FormGenListBagComposition::modelChanged()
+{
+    if( mUpdating )
+        return;
+
+    notifyValueChanged();
+}
+
+void FormGenListBagComposition::childValueChanged(const FormGenPath &path, const QVariant &newSubValue)
 {
     if( mUpdating )
         return;
@@ -670,11 +764,7 @@ void FormGenListBagComposition::childValueChanged()
     Q_ASSERT(currentRow >= 0);
 
     mUpdating = true;
-    if( mMode == ListMode ) {
-        mModel.list->editRow(currentRow, mElement->valueString(), mElement->value());
-    } else {
-        mModel.bag->editRow(currentRow, mElement->valueString(), mElement->value());
-    }
+    editRow(currentRow, mElement->valueString(), mElement->value(), path, newSubValue);
     mUpdating = false;
 }
 
@@ -752,6 +842,31 @@ void FormGenListBagComposition::insertNew()
     selectionModel()->setCurrentIndex(model()->index(newRow, 0), QItemSelectionModel::ClearAndSelect);
 }
 
+bool FormGenListBagComposition::rowOf(const QString &segment, int *row) const
+{
+    bool ok;
+    *row = segment.toInt(&ok);
+    return ok && *row >= 0 && *row < model()->rowCount();
+}
+
+void FormGenListBagComposition::editRow(int row, const QString &display, const QVariant &data,
+                                        const FormGenPath &subPath, const QVariant &newSubValue)
+{
+    int newRow = row;
+    if( mMode == ListMode ) {
+        mModel.list->editRow(row, display, data);
+    } else {
+        newRow = mModel.bag->editRow(row, display, data);
+    }
+
+    // a bag row that got moved by the edit changes the whole value; value() may
+    // still hold the snapshot from before the edit, so build it from the model
+    if( newRow == row )
+        emitSubValueChanged(subPath.prepended(QString::number(row)), newSubValue);
+    else
+        emitSubValueChanged(FormGenPath(), valueImpl());
+}
+
 QAbstractItemModel *FormGenListBagComposition::model() const
 {
     return mHead->listView->model();
@@ -20,6 +20,7 @@
 #define FORMGENWIDGETS_QT_COMPOSITIONWIDGETS_H
 
 #include "formgencompositionmodels.h"
+#include "formgencompositionschema.h"
 #include "formgenwidgetsbase.h"
 
 #include "formgenwidgets_global.h"
@@ -46,18 +47,19 @@ public:
     void addElement(const QString & tag, FormGenElement * element, const QString & label = QString());
     FormGenElement *element(const QString & tag) const;
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    void writeValueStringImpl(FormGenWriter &writer) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
-
-private slots:
-    void childValueChanged();
+    QVariant valueAtImpl(const FormGenPath &path) const override;
+    bool setValueAtImpl(const FormGenPath &path, const QVariant &val) override;
 
 private:
+    void childValueChanged(const QString &tag, const FormGenPath &path, const QVariant &newSubValue);
+
     enum CompositionUpdateState {
         NotUpdatingState,
         UpdatingState,
@@ -66,8 +68,8 @@ private:
 
     QFormLayout *mLayout;
     QVector<CompositionElement> mElements;
-    QHash<QString, int> mTagIndexMap;
     CompositionUpdateState mUpdating;
+    FormGenRecordNode mSchema;
 };
 
 
@@ -85,21 +87,25 @@ public:
     void addElement(const QString & tag, FormGenElement * element, const QString & label = QString());
     FormGenElement *element(const QString & tag) const;
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    void writeValueStringImpl(FormGenWriter &writer) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
+    QVariant valueAtImpl(const FormGenPath &path) const override;
+    bool setValueAtImpl(const FormGenPath &path, const QVariant &val) override;
 
 private:
+    void childValueChanged(int idx, const FormGenPath &path, const QVariant &newSubValue);
+
     QComboBox *mComboBox;
     QWidget *mElementContainer;
     QStackedLayout *mElementLayout;
     FormGenChoiceCompositionContainer *mContainer;
     QVector<CompositionElement> mElements;
-    QHash<QString, int> mTagIndexMap;
+    FormGenChoiceNode mSchema;
 };
 
 
@@ -124,20 +130,35 @@ public:
     Mode mode() const;
 
     void setCompareOperator(const FormGenBagModel::Compare &comparison);
-
-    QVariant defaultValue() const override;
+    template< class LessThan >
+    void setCompareFunctor(const LessThan &lessThan)
+    {
+        if( mMode == BagMode )
+            mModel.bag->setCompareFunctor(lessThan);
+    }
+    /// Sorts by sub values of the content element, see FormGenBagModel::setSortKeys.
+    void setSortKeys(const QVector<FormGenBagModel::SortKey> &keys);
+    /// Use TreeStorage for large bags that change often, see FormGenBagModel::Storage.
+    void setBagStorage(FormGenBagModel::Storage storage);
+    /// See FormGenBagModel::setParallelSorting.
+    void setBagParallelSorting(bool enabled);
+
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    void writeValueStringImpl(FormGenWriter &writer) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
+    QVariant valueAtImpl(const FormGenPath &path) const override;
+    bool setValueAtImpl(const FormGenPath &path, const QVariant &val) override;
 
 protected slots:
     void updateInputWidgets();
 
 private slots:
-    void childValueChanged();
+    void modelChanged();
+    void childValueChanged(const FormGenPath &path, const QVariant &newSubValue);
 
     void deleteCurrent();
     void clearAll();
@@ -148,6 +169,9 @@ private slots:
 private:
     QAbstractItemModel *model() const;
     QItemSelectionModel *selectionModel() const;
+    bool rowOf(const QString &segment, int *row) const;
+    void editRow(int row, const QString &display, const QVariant &data,
+                 const FormGenPath &subPath, const QVariant &newSubValue);
 
     Mode mMode;
     union {
@@ -159,6 +183,7 @@ private:
     FormGenElement * mElement;
     QWidget * mElementWrapper;
     bool mUpdating;
+    FormGenListBagNode mSchema;
 };
 
 #endif // FORMGENWIDGETS_QT_COMPOSITIONWIDGETS_H
@@ -0,0 +1,548 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "formgenregularschema.h"
+#include "formgenschemabase_p.h"
+
+#include "mathutils.h"
+
+#include <QDate>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QTime>
+
+#include <math.h>
+
+
+static const double s_doubleMax = (2.0 - pow(2, -52)) * pow(2, 1023);
+
+
+
+FormGenVoidNode::FormGenVoidNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenVoidNode::defaultValue() const
+{
+    return voidValue();
+}
+
+QVariant FormGenVoidNode::voidValue()
+{
+    return QVariant(QMetaType::VoidStar, nullptr);
+}
+
+FormGenAcceptResult FormGenVoidNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = stringSet();
+    return result;
+}
+
+FormGenAcceptResult FormGenVoidNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::VoidStar && val.value<void *>() == nullptr )
+        return FormGenAcceptResult::accept(val, {});
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenBoolNode::FormGenBoolNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenBoolNode::defaultValue() const
+{
+    return QVariant(false);
+}
+
+FormGenAcceptResult FormGenBoolNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = val.toBool() ? stringTrue() : stringFalse();
+    return result;
+}
+
+FormGenAcceptResult FormGenBoolNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::Bool )
+        return FormGenAcceptResult::accept(val, {});
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenEnumNode::FormGenEnumNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+bool FormGenEnumNode::addEnumValue(const QString &tag)
+{
+    if( ! tagPattern()->match(tag).hasMatch() ) {
+        qWarning("FormGenEnumNode::addEnumValue: tag must be nonempty and without / and control chars.");
+        return false;
+    }
+
+    mTags.append(tag);
+    return true;
+}
+
+QStringList FormGenEnumNode::enumValues() const
+{
+    return mTags;
+}
+
+QVariant FormGenEnumNode::defaultValue() const
+{
+    QVariantHash hash;
+    if( mTags.size() > 0 )
+        hash[mTags.first()] = FormGenVoidNode::voidValue();
+    return hash;
+}
+
+FormGenAcceptResult FormGenEnumNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable ) {
+        const QString &key = formGenBorrowedHash(val).cbegin().key();
+        result.valueString = objectString(QStringList( {keyStringValuePair(key, stringSet())} ));
+    }
+    return result;
+}
+
+FormGenAcceptResult FormGenEnumNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) != QMetaType::QVariantHash )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QVariantHash &hash = formGenBorrowedHash(val);
+    if( hash.size() != 1 )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QString &key = hash.cbegin().key();
+    if( hash.cbegin().value() != FormGenVoidNode::voidValue() )
+        return FormGenAcceptResult::reject(key, val);
+
+    if( ! mTags.contains(key) )
+        return FormGenAcceptResult::reject(key, val);
+
+    return FormGenAcceptResult::accept(val, {});
+}
+
+
+FormGenIntNode::FormGenIntNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+    , mMinimum(0)
+    , mMaximum(100)
+{
+}
+
+int FormGenIntNode::minimum() const
+{
+    return mMinimum;
+}
+
+void FormGenIntNode::setMinimum(int min)
+{
+    mMinimum = min;
+    mMaximum = qMax(mMinimum, mMaximum);
+}
+
+int FormGenIntNode::maximum() const
+{
+    return mMaximum;
+}
+
+void FormGenIntNode::setMaximum(int max)
+{
+    mMaximum = max;
+    mMinimum = qMin(mMinimum, mMaximum);
+}
+
+QVariant FormGenIntNode::defaultValue() const
+{
+    return QVariant(qBound(minimum(), 0, maximum()));
+}
+
+FormGenAcceptResult FormGenIntNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = QString::number(val.toInt());
+    return result;
+}
+
+FormGenAcceptResult FormGenIntNode::validateImpl(const QVariant &val) const
+{
+    if( MathUtils::isIntegerType(val) ) {
+        bool ok;
+        int v = val.toInt(&ok);
+        if( ok ) {
+            if( v == qBound(minimum(), v, maximum()) )
+                return FormGenAcceptResult::accept(val, {});
+        }
+    }
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenFloatNode::FormGenFloatNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+    , mMinimum(-s_doubleMax)
+    , mMaximum(s_doubleMax)
+{
+}
+
+double FormGenFloatNode::minimum() const
+{
+    return mMinimum;
+}
+
+void FormGenFloatNode::setMinimum(double min)
+{
+    if( ! std::isfinite(min) )
+        return;
+
+    mMinimum = min;
+    mMaximum = qMax(mMinimum, mMaximum);
+}
+
+double FormGenFloatNode::maximum() const
+{
+    return mMaximum;
+}
+
+void FormGenFloatNode::setMaximum(double max)
+{
+    if( ! std::isfinite(max) )
+        return;
+
+    mMaximum = max;
+    mMinimum = qMin(mMinimum, mMaximum);
+}
+
+QVariant FormGenFloatNode::defaultValue() const
+{
+    return QVariant(qBound(minimum(), double(0.0), maximum()));
+}
+
+FormGenAcceptResult FormGenFloatNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = MathUtils::floatB64ToString_RoundTripPrecision(val.toDouble());
+    return result;
+}
+
+FormGenAcceptResult FormGenFloatNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::Float || variantType(val) == QMetaType::Double ) {
+        double d = val.toDouble();
+
+        if( ! std::isfinite(d) )
+            return FormGenAcceptResult::reject({}, val);
+
+        if( d < minimum() || d > maximum() )
+            return FormGenAcceptResult::reject({}, val);
+
+        return FormGenAcceptResult::accept(val, {});
+    }
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenDateNode::FormGenDateNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenDateNode::defaultValue() const
+{
+    return QDate();
+}
+
+FormGenAcceptResult FormGenDateNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = val.toDate().toString(Qt::ISODate);
+    return result;
+}
+
+FormGenAcceptResult FormGenDateNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::QDate )
+        return FormGenAcceptResult::accept(val, {});
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenTimeNode::FormGenTimeNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenTimeNode::defaultValue() const
+{
+    return QTime();
+}
+
+FormGenAcceptResult FormGenTimeNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = val.toTime().toString(Qt::ISODate);
+    return result;
+}
+
+FormGenAcceptResult FormGenTimeNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::QTime )
+        return FormGenAcceptResult::accept(val, {});
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenDateTimeNode::FormGenDateTimeNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenDateTimeNode::defaultValue() const
+{
+    return QDateTime();
+}
+
+FormGenAcceptResult FormGenDateTimeNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = val.toDateTime().toString(Qt::ISODate);
+    return result;
+}
+
+FormGenAcceptResult FormGenDateTimeNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::QDateTime )
+        return FormGenAcceptResult::accept(val, {});
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenColorNode::FormGenColorNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenColorNode::defaultValue() const
+{
+    // only yields a color if QtGui registered its variant conversions
+    QVariant black(QStringLiteral("#000000"));
+    black.convert(QMetaType::QColor);
+    return black;
+}
+
+FormGenAcceptResult FormGenColorNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = val.toString();
+    return result;
+}
+
+FormGenAcceptResult FormGenColorNode::validateImpl(const QVariant &val) const
+{
+    // a default constructed QColor variant compares equal to any invalid color
+    if( variantType(val) == QMetaType::QColor && val != QVariant(QMetaType::QColor, nullptr) ) {
+        // #rrggbb for opaque colors, #aarrggbb otherwise
+        if( val.toString().size() == 7 )
+            return FormGenAcceptResult::accept(val, {});
+        else
+            qWarning("Color with alpha channel not supported"); // Color dialog has no alpha support, so be consistent
+    }
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenTextNode::FormGenTextNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenTextNode::defaultValue() const
+{
+    return QString();
+}
+
+FormGenAcceptResult FormGenTextNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( result.acceptable )
+        result.valueString = quotedString(val.toString());
+    return result;
+}
+
+FormGenAcceptResult FormGenTextNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) == QMetaType::QString )
+        return FormGenAcceptResult::accept(val, {});
+
+    return FormGenAcceptResult::reject({}, val);
+}
+
+
+FormGenFileUrlListNode::FormGenFileUrlListNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+QVariant FormGenFileUrlListNode::defaultValue() const
+{
+    return QVariantList();
+}
+
+FormGenAcceptResult FormGenFileUrlListNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( ! result.acceptable )
+        return result;
+
+    const QVariantList &list = formGenBorrowedList(val);
+
+    QStringList valueStrings;
+    valueStrings.reserve(list.size());
+    for( const auto &v : list )
+        valueStrings.append(quotedString(v.toString()));
+
+    result.valueString = joinedValueStringList(valueStrings);
+    return result;
+}
+
+FormGenAcceptResult FormGenFileUrlListNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) != QMetaType::QVariantList )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QVariantList &list = formGenBorrowedList(val);
+
+    for( int i = 0; i < list.size(); ++i ) {
+        if( variantType(list.at(i)) != QMetaType::QString )
+            return FormGenAcceptResult::reject(QString::number(i), list.at(i));
+    }
+
+    return FormGenAcceptResult::accept(val, {});
+}
+
+
+FormGenFormatStringNode::FormGenFormatStringNode(FormGenSchemaBase::ElementType type)
+    : FormGenSchemaNode(type)
+{
+}
+
+bool FormGenFormatStringNode::addVoidElement(const QString &tag)
+{
+    if( ! tagPattern()->match(tag).hasMatch() ) {
+        qWarning("FormGenFormatStringNode::addVoidElement: tag must be nonempty and without / and control chars.");
+        return false;
+    }
+
+    if( tag == textTag() ) {
+        qWarning("FormGenFormatStringNode::addVoidElement: text tag reserved.");
+        return false;
+    }
+
+    mVoidTags.insert(tag);
+    return true;
+}
+
+bool FormGenFormatStringNode::hasVoidElement(const QString &tag) const
+{
+    return mVoidTags.contains(tag);
+}
+
+QVariant FormGenFormatStringNode::defaultValue() const
+{
+    return QVariantList();
+}
+
+QString FormGenFormatStringNode::textTag()
+{
+    return QStringLiteral("text");
+}
+
+FormGenAcceptResult FormGenFormatStringNode::acceptsValueImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = validateImpl(val);
+    if( ! result.acceptable )
+        return result;
+
+    const QVariantList &variantList = formGenBorrowedList(val);
+    QStringList stringList;
+    stringList.reserve(variantList.size());
+    for( const auto &v : variantList ) {
+        const QVariantHash &element = formGenBorrowedHash(v);
+        const QString &key = element.cbegin().key();
+
+        QString keyValue = keyStringValuePair(key, key == textTag() ? element.cbegin().value().toString()
+                                                                    : stringSet());
+        stringList.append(objectString(QStringList({keyValue})));
+    }
+
+    result.valueString = joinedValueStringList(stringList);
+    return result;
+}
+
+FormGenAcceptResult FormGenFormatStringNode::validateImpl(const QVariant &val) const
+{
+    if( variantType(val) != QMetaType::QVariantList )
+        return FormGenAcceptResult::reject({}, val);
+
+    const QVariantList &variantList = formGenBorrowedList(val);
+    for( int i = 0; i < variantList.size(); ++i ) {
+        if( variantType(variantList.at(i)) != QMetaType::QVariantHash )
+            return FormGenAcceptResult::reject(QString::number(i), val);
+
+        const QVariantHash &element = formGenBorrowedHash(variantList.at(i));
+        if( element.size() != 1 )
+            return FormGenAcceptResult::reject(QString::number(i), val);
+
+        const QString &key = element.cbegin().key();
+
+        if( key == textTag() ) {
+            if( variantType(element.cbegin().value()) != QMetaType::QString )
+                return FormGenAcceptResult::reject(QString::number(i), val);
+        } else {
+            if( ! mVoidTags.contains(key) || element.cbegin().value() != FormGenVoidNode::voidValue() )
+                return FormGenAcceptResult::reject(QString::number(i), val);
+        }
+    }
+
+    return FormGenAcceptResult::accept(val, {});
+}
@@ -0,0 +1,217 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMGENWIDGETS_QT_REGULARSCHEMA_H
+#define FORMGENWIDGETS_QT_REGULARSCHEMA_H
+
+#include "formgenschemabase.h"
+
+#include <QSet>
+
+#include "formgenwidgets_global.h"
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenVoidNode : public FormGenSchemaNode {
+public:
+    explicit FormGenVoidNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+    static QVariant voidValue();
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenBoolNode : public FormGenSchemaNode {
+public:
+    explicit FormGenBoolNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenEnumNode : public FormGenSchemaNode {
+public:
+    explicit FormGenEnumNode(ElementType type = Required);
+
+    bool addEnumValue(const QString & tag);
+    QStringList enumValues() const;
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+
+private:
+    QStringList mTags;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenIntNode : public FormGenSchemaNode {
+public:
+    explicit FormGenIntNode(ElementType type = Required);
+
+    int minimum() const;
+    /// Also raises the maximum to min if necessary.
+    void setMinimum(int min);
+
+    int maximum() const;
+    /// Also lowers the minimum to max if necessary.
+    void setMaximum(int max);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+
+private:
+    int mMinimum;
+    int mMaximum;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenFloatNode : public FormGenSchemaNode {
+public:
+    explicit FormGenFloatNode(ElementType type = Required);
+
+    double minimum() const;
+    /// Ignores non-finite values, also raises the maximum to min if necessary.
+    void setMinimum(double min);
+
+    double maximum() const;
+    /// Ignores non-finite values, also lowers the minimum to max if necessary.
+    void setMaximum(double max);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+
+private:
+    double mMinimum;
+    double mMaximum;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenDateNode : public FormGenSchemaNode {
+public:
+    explicit FormGenDateNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenTimeNode : public FormGenSchemaNode {
+public:
+    explicit FormGenTimeNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenDateTimeNode : public FormGenSchemaNode {
+public:
+    explicit FormGenDateTimeNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+/**
+ * QColor is a QtGui type, so this node only inspects the variant through the
+ * QVariant interface (the value string is the #rrggbb color name). Colors with
+ * an alpha channel are not supported.
+ */
+class FORMGENWIDGETS_CORE_EXPORT FormGenColorNode : public FormGenSchemaNode {
+public:
+    explicit FormGenColorNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenTextNode : public FormGenSchemaNode {
+public:
+    explicit FormGenTextNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenFileUrlListNode : public FormGenSchemaNode {
+public:
+    explicit FormGenFileUrlListNode(ElementType type = Required);
+
+    QVariant defaultValue() const override;
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+};
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenFormatStringNode : public FormGenSchemaNode {
+public:
+    explicit FormGenFormatStringNode(ElementType type = Required);
+
+    bool addVoidElement(const QString & tag);
+    bool hasVoidElement(const QString & tag) const;
+
+    QVariant defaultValue() const override;
+
+    static QString textTag();
+
+protected:
+    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    FormGenAcceptResult validateImpl(const QVariant &val) const override;
+
+private:
+    QSet<QString> mVoidTags;
+};
+
+#endif // FORMGENWIDGETS_QT_REGULARSCHEMA_H
@@ -39,23 +39,20 @@
 #include <math.h>
 
 
-static const double s_doubleMax = (2.0 - pow(2, -52)) * pow(2, 1023);
-
-
-
 FormGenVoidWidget::FormGenVoidWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
+    , mSchema(type)
 {
 }
 
-QVariant FormGenVoidWidget::defaultValue() const
+const FormGenSchemaNode *FormGenVoidWidget::schemaNode() const
 {
-    return voidValue();
+    return &mSchema;
 }
 
 QVariant FormGenVoidWidget::voidValue()
 {
-    return QVariant(QMetaType::VoidStar, nullptr);
+    return FormGenVoidNode::voidValue();
 }
 
 QVariant FormGenVoidWidget::valueImpl() const
@@ -68,14 +65,6 @@ QString FormGenVoidWidget::valueStringImpl() const
     return stringSet();
 }
 
-FormGenAcceptResult FormGenVoidWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::VoidStar && val.value<void *>() == nullptr )
-        return FormGenAcceptResult::accept(val, stringSet());
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenVoidWidget::setVaidatedValueImpl(const QVariant &)
 {
 }
@@ -87,20 +76,21 @@ void FormGenVoidWidget::updateInputWidgets()
 
 FormGenBoolWidget::FormGenBoolWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
+    , mSchema(type)
 {
     mValue = new QComboBox;
     mValue->addItem(stringFalse());
     mValue->addItem(stringTrue());
-    connect(mValue, SIGNAL(currentIndexChanged(int)), this, SIGNAL(valueChanged()));
+    connect(mValue, SIGNAL(currentIndexChanged(int)), this, SLOT(notifyValueChanged()));
     hboxLayout()->addWidget(mValue, 1);
     mValue->setCurrentIndex(0);
 
     updateInputWidgets();
 }
 
-QVariant FormGenBoolWidget::defaultValue() const
+const FormGenSchemaNode *FormGenBoolWidget::schemaNode() const
 {
-    return QVariant(false);
+    return &mSchema;
 }
 
 QVariant FormGenBoolWidget::valueImpl() const
@@ -116,14 +106,6 @@ QString FormGenBoolWidget::valueStringImpl() const
     return valueImpl().toBool() ? stringTrue() : stringFalse();
 }
 
-FormGenAcceptResult FormGenBoolWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::Bool )
-        return FormGenAcceptResult::accept(val, val.toBool() ? stringTrue() : stringFalse());
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenBoolWidget::setVaidatedValueImpl(const QVariant &val)
 {
     mValue->setCurrentIndex(val.toBool() ? 1 : 0);
@@ -137,9 +119,10 @@ void FormGenBoolWidget::updateInputWidgets()
 
 FormGenEnumWidget::FormGenEnumWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
+    , mSchema(type)
 {
     mValue = new QComboBox;
-    connect(mValue, SIGNAL(currentIndexChanged(int)), this, SIGNAL(valueChanged()));
+    connect(mValue, SIGNAL(currentIndexChanged(int)), this, SLOT(notifyValueChanged()));
     hboxLayout()->addWidget(mValue, 1);
 
     updateInputWidgets();
@@ -147,31 +130,24 @@ FormGenEnumWidget::FormGenEnumWidget(FormGenElement::ElementType type, QWidget *
 
 void FormGenEnumWidget::addEnumValue(const QString &tag, const QString &label)
 {
-    if( ! tagPattern()->match(tag).hasMatch() ) {
-        qWarning("FormGenChoiceComposition::addElement: tag must be nonempty and without / and control chars.");
+    if( ! mSchema.addEnumValue(tag) )
         return;
-    }
-
-    mTags.append(tag);
 
     mValue->addItem(label.isEmpty() ? tag : label);
     if( mValue->currentIndex() < 0 )
         mValue->setCurrentIndex(0);
 }
 
-QVariant FormGenEnumWidget::defaultValue() const
+const FormGenSchemaNode *FormGenEnumWidget::schemaNode() const
 {
-    QVariantHash hash;
-    if( mTags.size() > 0 )
-        hash[mTags.first()] = QVariant(QMetaType::VoidStar, nullptr);
-    return hash;
+    return &mSchema;
 }
 
 QVariant FormGenEnumWidget::valueImpl() const
 {
     QVariantHash hash;
     if( mValue->currentIndex() >= 0 )
-        hash[mTags.at(mValue->currentIndex())] = QVariant(QMetaType::VoidStar, nullptr);
+        hash[mSchema.enumValues().at(mValue->currentIndex())] = FormGenVoidNode::voidValue();
     return hash;
 }
 
@@ -180,34 +156,15 @@ QString FormGenEnumWidget::valueStringImpl() const
     if( mValue->currentIndex() < 0 )
         return objectString(QStringList());
 
-    QString keyValue = keyStringValuePair(mTags.at(mValue->currentIndex()),
+    QString keyValue = keyStringValuePair(mSchema.enumValues().at(mValue->currentIndex()),
                                           stringSet());
     return objectString(QStringList({keyValue}));
 }
 
-FormGenAcceptResult FormGenEnumWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) != QMetaType::QVariantHash )
-        return FormGenAcceptResult::reject({}, val);
-
-    QVariantHash hash = val.toHash();
-    if( hash.size() != 1 )
-        return FormGenAcceptResult::reject({}, val);
-
-    const QString key = hash.cbegin().key();
-    if( hash.cbegin().value() != QVariant(QMetaType::VoidStar, nullptr) )
-        return FormGenAcceptResult::reject(key, val);
-
-    if( ! mTags.contains(key) )
-        return FormGenAcceptResult::reject(key, val);
-
-    return FormGenAcceptResult::accept(val, objectString(QStringList( {keyStringValuePair(key, stringSet())} )));
-}
-
 void FormGenEnumWidget::setVaidatedValueImpl(const QVariant &val)
 {
     QVariantHash hash = val.toHash();
-    int idx = mTags.indexOf(hash.cbegin().key());
+    int idx = mSchema.enumValues().indexOf(hash.cbegin().key());
     mValue->setCurrentIndex(idx);
 }
 
@@ -220,12 +177,11 @@ void FormGenEnumWidget::updateInputWidgets()
 FormGenIntWidget::FormGenIntWidget(FormGenIntWidget::InputStyle inputStyle, FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
     , mStyle(inputStyle)
-    , mMinimum(0)
-    , mMaximum(100)
     , mValue(0)
     , mSpinBox(nullptr)
     , mSlider(nullptr)
     , mPlain(nullptr)
+    , mSchema(type)
 {
     setupStyle();
 }
@@ -247,47 +203,51 @@ void FormGenIntWidget::setInputStyle(FormGenIntWidget::InputStyle s)
 
 int FormGenIntWidget::minimum() const
 {
-    return mMinimum;
+    return mSchema.minimum();
 }
 
 void FormGenIntWidget::setMinimum(int min)
 {
-    if( mMinimum == min )
+    if( minimum() == min )
         return;
 
-    mMinimum = min;
+    const int oldMaximum = maximum();
+    mSchema.setMinimum(min);
     if( mSpinBox )
-        mSpinBox->setMinimum(min);
+        mSpinBox->setRange(minimum(), maximum());
     if( mSlider )
-        mSlider->setMinimum(min);
+        mSlider->setRange(minimum(), maximum());
     emit minimumChanged();
-    setMaximum(qMax(minimum(), maximum()));
+    if( maximum() != oldMaximum )
+        emit maximumChanged();
     setIntValue(qBound(minimum(), mValue, maximum()));
 }
 
 int FormGenIntWidget::maximum() const
 {
-    return mMaximum;
+    return mSchema.maximum();
 }
 
 void FormGenIntWidget::setMaximum(int max)
 {
-    if( mMaximum == max )
+    if( maximum() == max )
         return;
 
-    mMaximum = max;
+    const int oldMinimum = minimum();
+    mSchema.setMaximum(max);
     if( mSpinBox )
-        mSpinBox->setMaximum(max);
+        mSpinBox->setRange(minimum(), maximum());
     if( mSlider )
-        mSlider->setMaximum(max);
+        mSlider->setRange(minimum(), maximum());
     emit maximumChanged();
-    setMinimum(qMin(minimum(), maximum()));
+    if( minimum() != oldMinimum )
+        emit minimumChanged();
     setIntValue(qBound(minimum(), mValue, maximum()));
 }
 
-QVariant FormGenIntWidget::defaultValue() const
+const FormGenSchemaNode *FormGenIntWidget::schemaNode() const
 {
-    return QVariant(qBound(minimum(), 0, maximum()));
+    return &mSchema;
 }
 
 QVariant FormGenIntWidget::valueImpl() const
@@ -300,20 +260,6 @@ QString FormGenIntWidget::valueStringImpl() const
     return QString::number(mValue);
 }
 
-FormGenAcceptResult FormGenIntWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( MathUtils::isIntegerType(val) ) {
-        bool ok;
-        int v = val.toInt(&ok);
-        if( ok ) {
-            if( v == qBound(minimum(), v, maximum()) )
-                return FormGenAcceptResult::accept(val, QString::number(v));
-        }
-    }
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenIntWidget::setVaidatedValueImpl(const QVariant &val)
 {
     setIntValue(val.toInt());
@@ -365,7 +311,7 @@ void FormGenIntWidget::setIntValue(int val)
         return;
 
     mValue = val;
-    emit valueChanged();
+    notifyValueChanged();
 }
 
 void FormGenIntWidget::setupStyle()
@@ -447,8 +393,7 @@ void FormGenIntWidget::setPlain(bool set)
 
 FormGenFloatWidget::FormGenFloatWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
-    , mMinimum(-s_doubleMax)
-    , mMaximum(s_doubleMax)
+    , mSchema(type)
 {
     mValue = defaultValue().toDouble();
 
@@ -461,45 +406,49 @@ FormGenFloatWidget::FormGenFloatWidget(FormGenElement::ElementType type, QWidget
 
 double FormGenFloatWidget::minimum() const
 {
-    return mMinimum;
+    return mSchema.minimum();
 }
 
 void FormGenFloatWidget::setMinimum(double min)
 {
-    if( mMinimum == min )
+    if( minimum() == min )
         return;
 
     if( ! std::isfinite(min) )
         return;
 
-    mMinimum = min;
+    const double oldMaximum = maximum();
+    mSchema.setMinimum(min);
     emit minimumChanged();
-    setMaximum(qMax(minimum(), maximum()));
+    if( maximum() != oldMaximum )
+        emit maximumChanged();
     setDoubleValue(qBound(minimum(), mValue, maximum()));
 }
 
 double FormGenFloatWidget::maximum() const
 {
-    return mMaximum;
+    return mSchema.maximum();
 }
 
 void FormGenFloatWidget::setMaximum(double max)
 {
-    if( mMaximum == max )
+    if( maximum() == max )
         return;
 
     if( ! std::isfinite(max) )
         return;
 
-    mMaximum = max;
+    const double oldMinimum = minimum();
+    mSchema.setMaximum(max);
     emit maximumChanged();
-    setMinimum(qMin(minimum(), maximum()));
+    if( minimum() != oldMinimum )
+        emit minimumChanged();
     setDoubleValue(qBound(minimum(), mValue, maximum()));
 }
 
-QVariant FormGenFloatWidget::defaultValue() const
+const FormGenSchemaNode *FormGenFloatWidget::schemaNode() const
 {
-    return QVariant(qBound(minimum(), double(0.0), maximum()));
+    return &mSchema;
 }
 
 QVariant FormGenFloatWidget::valueImpl() const
@@ -512,23 +461,6 @@ QString FormGenFloatWidget::valueStringImpl() const
     return MathUtils::floatB64ToString_RoundTripPrecision(mValue);
 }
 
-FormGenAcceptResult FormGenFloatWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::Float || variantType(val) == QMetaType::Double ) {
-        float d = val.toDouble();
-
-        if( ! std::isfinite(d) )
-            return FormGenAcceptResult::reject({}, val);
-
-        if( d < minimum() || d > maximum() )
-            return FormGenAcceptResult::reject({}, val);
-
-        return FormGenAcceptResult::accept(val, MathUtils::floatB64ToString_RoundTripPrecision(d));
-    }
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenFloatWidget::setVaidatedValueImpl(const QVariant &val)
 {
     setDoubleValue(val.toDouble());
@@ -555,25 +487,26 @@ void FormGenFloatWidget::setDoubleValue(double val)
         return;
 
     mValue = val;
-    emit valueChanged();
+    notifyValueChanged();
 }
 
 
 FormGenDateWidget::FormGenDateWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
+    , mSchema(type)
 {
     mEdit = new QDateEdit;
     mEdit->setCalendarPopup(true);
     mEdit->setDisplayFormat(QStringLiteral("yyyy-MM-dd"));
-    connect(mEdit, &QDateEdit::dateChanged, this, &FormGenElement::valueChanged);
+    connect(mEdit, &QDateEdit::dateChanged, this, &FormGenDateWidget::notifyValueChanged);
     hboxLayout()->addWidget(mEdit, 1);
 
     updateInputWidgets();
 }
 
-QVariant FormGenDateWidget::defaultValue() const
+const FormGenSchemaNode *FormGenDateWidget::schemaNode() const
 {
-    return QDate();
+    return &mSchema;
 }
 
 QVariant FormGenDateWidget::valueImpl() const
@@ -586,14 +519,6 @@ QString FormGenDateWidget::valueStringImpl() const
     return mEdit->date().toString(Qt::ISODate);
 }
 
-FormGenAcceptResult FormGenDateWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::QDate )
-        return FormGenAcceptResult::accept(val, val.toDate().toString(Qt::ISODate));
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenDateWidget::setVaidatedValueImpl(const QVariant &val)
 {
     mEdit->setDate(val.toDate());
@@ -607,18 +532,19 @@ void FormGenDateWidget::updateInputWidgets()
 
 FormGenTimeWidget::FormGenTimeWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
+    , mSchema(type)
 {
     mEdit = new QTimeEdit;
     mEdit->setDisplayFormat(QStringLiteral("HH:mm:ss.zzz"));
-    connect(mEdit, &QTimeEdit::timeChanged, this, &FormGenElement::valueChanged);
+    connect(mEdit, &QTimeEdit::timeChanged, this, &FormGenTimeWidget::notifyValueChanged);
     hboxLayout()->addWidget(mEdit, 1);
 
     updateInputWidgets();
 }
 
-QVariant FormGenTimeWidget::defaultValue() const
+const FormGenSchemaNode *FormGenTimeWidget::schemaNode() const
 {
-    return QTime();
+    return &mSchema;
 }
 
 QVariant FormGenTimeWidget::valueImpl() const
@@ -631,14 +557,6 @@ QString FormGenTimeWidget::valueStringImpl() const
     return mEdit->time().toString(Qt::ISODate);
 }
 
-FormGenAcceptResult FormGenTimeWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::QTime )
-        return FormGenAcceptResult::accept(val, val.toTime().toString(Qt::ISODate));
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenTimeWidget::setVaidatedValueImpl(const QVariant &val)
 {
     mEdit->setTime(val.toTime());
@@ -652,19 +570,20 @@ void FormGenTimeWidget::updateInputWidgets()
 
 FormGenDateTimeWidget::FormGenDateTimeWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
+    , mSchema(type)
 {
     mEdit = new QDateTimeEdit;
     mEdit->setCalendarPopup(true);
     mEdit->setDisplayFormat(QStringLiteral("yyyy-MM-dd T HH:mm:ss.zzz t"));
-    connect(mEdit, &QDateTimeEdit::dateTimeChanged, this, &FormGenElement::valueChanged);
+    connect(mEdit, &QDateTimeEdit::dateTimeChanged, this, &FormGenDateTimeWidget::notifyValueChanged);
     hboxLayout()->addWidget(mEdit, 1);
 
     updateInputWidgets();
 }
 
-QVariant FormGenDateTimeWidget::defaultValue() const
+const FormGenSchemaNode *FormGenDateTimeWidget::schemaNode() const
 {
-    return QDateTime();
+    return &mSchema;
 }
 
 QVariant FormGenDateTimeWidget::valueImpl() const
@@ -677,14 +596,6 @@ QString FormGenDateTimeWidget::valueStringImpl() const
     return mEdit->dateTime().toString(Qt::ISODate);
 }
 
-FormGenAcceptResult FormGenDateTimeWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::QDateTime )
-        return FormGenAcceptResult::accept(val, val.toDateTime().toString(Qt::ISODate));
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenDateTimeWidget::setVaidatedValueImpl(const QVariant &val)
 {
     mEdit->setDateTime(val.toDateTime());
@@ -699,6 +610,7 @@ void FormGenDateTimeWidget::updateInputWidgets()
 FormGenColorWidget::FormGenColorWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
     , mValue(Qt::black)
+    , mSchema(type)
 {
     mButton = new QPushButton;
     connect(mButton, &QPushButton::clicked, this, &FormGenColorWidget::showColorChooser);
@@ -707,9 +619,9 @@ FormGenColorWidget::FormGenColorWidget(FormGenElement::ElementType type, QWidget
     updateInputWidgets();
 }
 
-QVariant FormGenColorWidget::defaultValue() const
+const FormGenSchemaNode *FormGenColorWidget::schemaNode() const
 {
-    return QColor(Qt::black);
+    return &mSchema;
 }
 
 QVariant FormGenColorWidget::valueImpl() const
@@ -722,21 +634,6 @@ QString FormGenColorWidget::valueStringImpl() const
     return mValue.name();
 }
 
-FormGenAcceptResult FormGenColorWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::QColor ) {
-        auto c = val.value<QColor>();
-        if( c.isValid() ) {
-            if( c.alpha() == 255 )
-                return FormGenAcceptResult::accept(val, c.name());
-            else
-                qWarning("Color with alpha channel not supported"); // Color dialog has no alpha support, so be consistent
-        }
-    }
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenColorWidget::setVaidatedValueImpl(const QVariant &val)
 {
     QColor c = val.value<QColor>();
@@ -745,7 +642,7 @@ void FormGenColorWidget::setVaidatedValueImpl(const QVariant &val)
         return;
 
     mValue = c;
-    emit valueChanged();
+    notifyValueChanged();
 }
 
 void FormGenColorWidget::updateInputWidgets()
@@ -767,16 +664,17 @@ void FormGenColorWidget::showColorChooser()
 FormGenTextWidget::FormGenTextWidget(FormGenElement::ElementType type, QWidget *parent)
     : FormGenUnframedBase(type, parent)
     , mEdit(new QLineEdit)
+    , mSchema(type)
 {
-    connect(mEdit, &QLineEdit::textChanged, this, &FormGenElement::valueChanged);
+    connect(mEdit, &QLineEdit::textChanged, this, &FormGenTextWidget::notifyValueChanged);
     hboxLayout()->addWidget(mEdit, 1);
 
     updateInputWidgets();
 }
 
-QVariant FormGenTextWidget::defaultValue() const
+const FormGenSchemaNode *FormGenTextWidget::schemaNode() const
 {
-    return QString();
+    return &mSchema;
 }
 
 QVariant FormGenTextWidget::valueImpl() const
@@ -789,14 +687,6 @@ QString FormGenTextWidget::valueStringImpl() const
     return quotedString(mEdit->text());
 }
 
-FormGenAcceptResult FormGenTextWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) == QMetaType::QString )
-        return FormGenAcceptResult::accept(val, quotedString(val.toString()));
-
-    return FormGenAcceptResult::reject({}, val);
-}
-
 void FormGenTextWidget::setVaidatedValueImpl(const QVariant &val)
 {
     const QString s = val.toString();
@@ -904,15 +794,16 @@ FormGenFileUrlList::FormGenFileUrlList(FormGenElement::ElementType type, QWidget
     , mModel(new FormGenFileUrlListModel(this))
     , mHead(new Ui::FormGenFileListHead)
     , mHeadWidget(new QWidget)
+    , mSchema(type)
 {
     mHead->setupUi(mHeadWidget);
     mModel->setEmptyUrlColor(palette().color(QPalette::Disabled, QPalette::Text));
 
-    connect(mModel, &QAbstractListModel::dataChanged, this, &FormGenFileUrlList::valueChanged);
-    connect(mModel, &QAbstractListModel::modelReset, this, &FormGenFileUrlList::valueChanged);
-    connect(mModel, &QAbstractListModel::rowsInserted, this, &FormGenFileUrlList::valueChanged);
-    connect(mModel, &QAbstractListModel::rowsMoved, this, &FormGenFileUrlList::valueChanged);
-    connect(mModel, &QAbstractListModel::rowsRemoved, this, &FormGenFileUrlList::valueChanged);
+    connect(mModel, &QAbstractListModel::dataChanged, this, &FormGenFileUrlList::notifyValueChanged);
+    connect(mModel, &QAbstractListModel::modelReset, this, &FormGenFileUrlList::notifyValueChanged);
+    connect(mModel, &QAbstractListModel::rowsInserted, this, &FormGenFileUrlList::notifyValueChanged);
+    connect(mModel, &QAbstractListModel::rowsMoved, this, &FormGenFileUrlList::notifyValueChanged);
+    connect(mModel, &QAbstractListModel::rowsRemoved, this, &FormGenFileUrlList::notifyValueChanged);
     connect(this, &FormGenElement::valueChanged, this, &FormGenFileUrlList::updateInputWidgets);
 
     mHead->listView->setModel(mModel);
@@ -962,9 +853,9 @@ FormGenFileUriChooseOptions FormGenFileUrlList::chooseOptions() const
     return mChooseOptions;
 }
 
-QVariant FormGenFileUrlList::defaultValue() const
+const FormGenSchemaNode *FormGenFileUrlList::schemaNode() const
 {
-    return QVariantList();
+    return &mSchema;
 }
 
 QVariant FormGenFileUrlList::valueImpl() const
@@ -987,22 +878,12 @@ QString FormGenFileUrlList::valueStringImpl() const
     return joinedValueStringList(list);
 }
 
-FormGenAcceptResult FormGenFileUrlList::acceptsValueImpl(const QVariant &val) const
+void FormGenFileUrlList::writeValueStringImpl(FormGenWriter &writer) const
 {
-    if( variantType(val) != QMetaType::QVariantList )
-        return FormGenAcceptResult::reject({}, val);
-
-    const QVariantList list = val.toList();
-
-    QStringList valueStrings;
-
-    for( int i = 0; i < list.size(); ++i ) {
-        if( variantType(list.at(i)) != QMetaType::QString )
-            return FormGenAcceptResult::reject(QString::number(i), list.at(i));
-        valueStrings.append(quotedString(list.at(i).toString()));
-    }
-
-    return FormGenAcceptResult::accept(val, joinedValueStringList(valueStrings));
+    writer.beginList();
+    for( int i = 0; i < mModel->rowCount({}); ++i )
+        writer.writeQuotedString(mModel->urlAt(i));
+    writer.endList();
 }
 
 void FormGenFileUrlList::setVaidatedValueImpl(const QVariant &val)
@@ -1111,8 +992,9 @@ FormGenFormatStringWidget::FormGenFormatStringWidget(FormGenElement::ElementType
     : FormGenUnframedBase(type, parent)
     , mTextEdit(new QTextEdit)
     , mInsertMenu(new QComboBox)
+    , mSchema(type)
 {
-    connect(mTextEdit, &QTextEdit::textChanged, this, &FormGenElement::valueChanged);
+    connect(mTextEdit, &QTextEdit::textChanged, this, &FormGenFormatStringWidget::notifyValueChanged);
     mTextEdit->setMaximumHeight(fontMetrics().height() * 2);
     hboxLayout()->addWidget(mTextEdit, 1);
 
@@ -1129,28 +1011,20 @@ FormGenFormatStringWidget::FormGenFormatStringWidget(FormGenElement::ElementType
 
 void FormGenFormatStringWidget::addVoidElement(const QString &tag)
 {
-    if( ! tagPattern()->match(tag).hasMatch() ) {
-        qWarning("FormGenFormatStringWidget::addVoidElement: tag must be nonempty and without / and control chars.");
+    if( ! mSchema.addVoidElement(tag) )
         return;
-    }
-
-    if( tag == textTag() ) {
-        qWarning("FormGenFormatStringWidget::addVoidElement: text tag reserved.");
-        return;
-    }
 
     mInsertMenu->addItem(tag);
-    mVoidTags.insert(tag);
 }
 
-QVariant FormGenFormatStringWidget::defaultValue() const
+const FormGenSchemaNode *FormGenFormatStringWidget::schemaNode() const
 {
-    return QVariantList();
+    return &mSchema;
 }
 
 QString FormGenFormatStringWidget::textTag()
 {
-    return QStringLiteral("text");
+    return FormGenFormatStringNode::textTag();
 }
 
 QVariant FormGenFormatStringWidget::valueImpl() const
@@ -1172,7 +1046,7 @@ QVariant FormGenFormatStringWidget::valueImpl() const
                 }
                 QVariantHash v;
                 v[ fragIt.fragment().charFormat().property(FormGenFormatStringTextObject::VoidTag).toString() ]
-                        = QVariant(QMetaType::VoidStar, nullptr);
+                        = FormGenVoidNode::voidValue();
                 list.append(v);
             } else {
                 tmp += fragIt.fragment().text();
@@ -1205,42 +1079,6 @@ QString FormGenFormatStringWidget::valueStringImpl() const
     return joinedValueStringList(stringList);
 }
 
-FormGenAcceptResult FormGenFormatStringWidget::acceptsValueImpl(const QVariant &val) const
-{
-    if( variantType(val) != QMetaType::QVariantList )
-        return FormGenAcceptResult::reject({}, val);
-
-    const QVariantList variantList = val.toList();
-    QStringList stringList;
-    for( int i = 0; i < variantList.size(); ++i ) {
-        if( variantType(variantList.at(i)) != QMetaType::QVariantHash )
-            return FormGenAcceptResult::reject(QString::number(i), val);
-
-        const QVariantHash element = variantList.at(i).toHash();
-        if( element.size() != 1 )
-            return FormGenAcceptResult::reject(QString::number(i), val);
-
-        const QString key = element.begin().key();
-
-        if( key == textTag() ) {
-            const QVariant v = element.begin().value();
-            if( variantType(v) != QMetaType::QString )
-                return FormGenAcceptResult::reject(QString::number(i), val);
-
-            QString keyValue = keyStringValuePair(key, v.toString());
-            stringList.append(objectString(QStringList({keyValue})));
-        } else {
-            if( ! mVoidTags.contains(key) || element.begin().value() != QVariant(QMetaType::VoidStar, nullptr) )
-                return FormGenAcceptResult::reject(QString::number(i), val);
-
-            QString keyValue = keyStringValuePair(key, stringSet());
-            stringList.append(objectString(QStringList({keyValue})));
-        }
-    }
-
-    return FormGenAcceptResult::accept(val, joinedValueStringList(stringList));
-}
-
 void FormGenFormatStringWidget::setVaidatedValueImpl(const QVariant &val)
 {
     mTextEdit->clear();
@@ -19,10 +19,9 @@
 #ifndef FORMGENWIDGETS_QT_REGULARWIDGETS_H
 #define FORMGENWIDGETS_QT_REGULARWIDGETS_H
 
+#include "formgenregularschema.h"
 #include "formgenwidgetsbase.h"
 
-#include <QSet>
-
 #include "formgenwidgets_global.h"
 
 class QComboBox;
@@ -48,17 +47,19 @@ class FORMGENWIDGETS_EXPORT FormGenVoidWidget : public FormGenUnframedBase {
 public:
     explicit FormGenVoidWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
     static QVariant voidValue();
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
+
+private:
+    FormGenVoidNode mSchema;
 };
 
 
@@ -68,18 +69,18 @@ class FORMGENWIDGETS_EXPORT FormGenBoolWidget : public FormGenUnframedBase {
 public:
     explicit FormGenBoolWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
 
 private:
     QComboBox * mValue;
+    FormGenBoolNode mSchema;
 };
 
 
@@ -91,19 +92,18 @@ public:
 
     void addEnumValue(const QString & tag, const QString & label = QString());
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
 
 private:
     QComboBox * mValue;
-    QStringList mTags;
+    FormGenEnumNode mSchema;
 };
 
 
@@ -130,7 +130,7 @@ public:
     int maximum() const;
     void setMaximum(int max);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 signals:
     void inputStyleChanged();
@@ -140,7 +140,6 @@ signals:
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
@@ -157,12 +156,11 @@ private:
     void setPlain(bool set);
 
     InputStyle mStyle;
-    int mMinimum;
-    int mMaximum;
     int mValue;
     QSpinBox * mSpinBox;
     QSlider * mSlider;
     QLineEdit * mPlain;
+    FormGenIntNode mSchema;
 };
 
 
@@ -180,7 +178,7 @@ public:
     double maximum() const;
     void setMaximum(double max);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 signals:
     void minimumChanged();
@@ -189,7 +187,6 @@ signals:
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
@@ -200,10 +197,9 @@ private slots:
 private:
     void setDoubleValue(double val);
 
-    double mMinimum;
-    double mMaximum;
     double mValue;
     QLineEdit * mEdit;
+    FormGenFloatNode mSchema;
 };
 
 
@@ -213,18 +209,18 @@ class FORMGENWIDGETS_EXPORT FormGenDateWidget : public FormGenUnframedBase {
 public:
     explicit FormGenDateWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
 
 private:
     QDateEdit * mEdit;
+    FormGenDateNode mSchema;
 };
 
 
@@ -234,18 +230,18 @@ class FORMGENWIDGETS_EXPORT FormGenTimeWidget : public FormGenUnframedBase {
 public:
     explicit FormGenTimeWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
 
 private:
     QTimeEdit * mEdit;
+    FormGenTimeNode mSchema;
 };
 
 
@@ -255,18 +251,18 @@ class FORMGENWIDGETS_EXPORT FormGenDateTimeWidget : public FormGenUnframedBase {
 public:
     explicit FormGenDateTimeWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
 
 private:
     QDateTimeEdit * mEdit;
+    FormGenDateTimeNode mSchema;
 };
 
 
@@ -276,12 +272,11 @@ class FORMGENWIDGETS_EXPORT FormGenColorWidget : public FormGenUnframedBase {
 public:
     explicit FormGenColorWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
@@ -292,6 +287,7 @@ private slots:
 private:
     QColor mValue;
     QPushButton * mButton;
+    FormGenColorNode mSchema;
 };
 
 
@@ -301,18 +297,18 @@ class FORMGENWIDGETS_EXPORT FormGenTextWidget : public FormGenUnframedBase {
 public:
     explicit FormGenTextWidget(ElementType type = Required, QWidget * parent = nullptr);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
 
 private:
     QLineEdit * mEdit;
+    FormGenTextNode mSchema;
 };
 
 
@@ -366,12 +362,12 @@ public:
     void setChooseOptions(FormGenFileUriChooseOptions opt);
     FormGenFileUriChooseOptions chooseOptions() const;
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
+    void writeValueStringImpl(FormGenWriter &writer) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
 protected slots:
@@ -391,6 +387,7 @@ private:
     FormGenFileUrlListModel * const mModel;
     Ui::FormGenFileListHead * const mHead;
     QWidget * const mHeadWidget;
+    FormGenFileUrlListNode mSchema;
 };
 
 
@@ -402,14 +399,13 @@ public:
 
     void addVoidElement(const QString & tag);
 
-    QVariant defaultValue() const override;
+    const FormGenSchemaNode *schemaNode() const override;
 
     static QString textTag();
 
 protected:
     QVariant valueImpl() const override;
     QString valueStringImpl() const override;
-    FormGenAcceptResult acceptsValueImpl(const QVariant &val) const override;
     void setVaidatedValueImpl(const QVariant &val) override;
 
     void updateInputWidgets() override;
@@ -420,9 +416,9 @@ private slots:
 private:
     void insertVoidElement(const QString &voidTag);
 
-    QSet<QString> mVoidTags;
     QTextEdit * const mTextEdit;
     QComboBox * const mInsertMenu;
+    FormGenFormatStringNode mSchema;
 };
 
 #endif // FORMGENWIDGETS_QT_REGULARWIDGETS_H
@@ -17,6 +17,7 @@
  */
 
 #include "formgenregularwidgets_p.h"
+#include "formgenrowruns_p.h"
 
 #include <QMimeData>
 #include <QPainter>
@@ -150,8 +151,7 @@ bool FormGenFileUrlListModel::removeRows(int row, int count, const QModelIndex &
         return false;
 
     beginRemoveRows(parent, row, row + count - 1);
-    for( int i = 0; i < count; ++i )
-        mItems.removeAt(row);
+    mItems.erase(mItems.begin() + row, mItems.begin() + row + count);
     endRemoveRows();
 
     return true;
@@ -176,12 +176,19 @@ void FormGenFileUrlListModel::removeUrl(int row)
 
 void FormGenFileUrlListModel::removeUrls(const QModelIndexList &rows)
 {
-    QMap<int, bool> rowIdx;
-    for( const auto r : rows )
-        rowIdx[-r.row()] = true;
-
-    for( auto it = rowIdx.cbegin(); it != rowIdx.cend(); ++it )
-        removeUrl(-it.key());
+    QVector<int> rowNumbers;
+    rowNumbers.reserve(rows.size());
+    for( const auto &r : rows )
+        rowNumbers.append(r.row());
+
+    const FormGenRowRuns runs = formGenRowRuns(rowNumbers, mItems.size());
+    formGenRemoveRuns(runs, mItems.size(), [this] (int first, int last) {
+        removeRows(first, last - first);
+    }, [this, &runs] {
+        beginResetModel();
+        mItems = formGenWithoutRuns(mItems, runs);
+        endResetModel();
+    });
 }
 
 void FormGenFileUrlListModel::insertUrl(const QUrl &url, int row)
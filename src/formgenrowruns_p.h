@@ -0,0 +1,124 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMGENWIDGETS_QT_ROWRUNS_P_H
+#define FORMGENWIDGETS_QT_ROWRUNS_P_H
+
+#include <QPair>
+#include <QVector>
+
+#include <algorithm>
+
+
+// Ascending [first, last) runs of adjacent rows of a list model.
+typedef QVector<QPair<int, int> > FormGenRowRuns;
+
+// Every run of rows signalled on its own shifts the rows behind it, in the views and in
+// list storage. Up to this many times the row count of shifted rows in total, that still
+// beats a model reset, which loses the scroll position and the current index of the views.
+static const int s_maxRunShiftsPerRow = 64;
+
+// The runs of the rows below rowCount among rows, given in any order.
+inline FormGenRowRuns formGenRowRuns(QVector<int> rows, int rowCount)
+{
+    std::sort(rows.begin(), rows.end());
+
+    FormGenRowRuns runs;
+    for( const int row : rows ) {
+        if( row < 0 || row >= rowCount )
+            continue;
+        if( ! runs.isEmpty() && runs.last().second >= row )
+            runs.last().second = row + 1;
+        else
+            runs.append(qMakePair(row, row + 1));
+    }
+    return runs;
+}
+
+// The runs of the rows matches(row) is true for.
+template< class Matches >
+FormGenRowRuns formGenMatchingRuns(int rowCount, const Matches &matches)
+{
+    FormGenRowRuns runs;
+    for( int row = 0; row < rowCount; ++row ) {
+        if( ! matches(row) )
+            continue;
+        if( ! runs.isEmpty() && runs.last().second == row )
+            ++runs.last().second;
+        else
+            runs.append(qMakePair(row, row + 1));
+    }
+    return runs;
+}
+
+inline int formGenRunsSize(const FormGenRowRuns &runs)
+{
+    int size = 0;
+    for( const auto &run : runs )
+        size += run.second - run.first;
+    return size;
+}
+
+// Whether to signal the runs of rows removed from, or inserted into, rowCount rows one by one
+// rather than to reset the model.
+inline bool formGenSignalsRunsSeparately(const FormGenRowRuns &runs, int rowCount)
+{
+    qint64 shifted = 0;
+    for( const auto &run : runs )
+        shifted += rowCount - run.first;
+    return shifted <= qint64(s_maxRunShiftsPerRow) * rowCount;
+}
+
+// Removes the runs of rows of a model with rowCount rows: removeRun(first, last) is called for
+// each run from the back, so the runs ahead keep their rows, to remove it between
+// beginRemoveRows and endRemoveRows. If formGenSignalsRunsSeparately advises against that,
+// removeAll() is called once instead, to remove all of them within a model reset.
+template< class RemoveRun, class RemoveAll >
+void formGenRemoveRuns(const FormGenRowRuns &runs, int rowCount, const RemoveRun &removeRun,
+                       const RemoveAll &removeAll)
+{
+    if( runs.isEmpty() )
+        return;
+
+    if( ! formGenSignalsRunsSeparately(runs, rowCount) ) {
+        removeAll();
+        return;
+    }
+
+    for( int i = runs.size() - 1; i >= 0; --i )
+        removeRun(runs.at(i).first, runs.at(i).second);
+}
+
+// The items of list outside the runs, with one pass over it.
+template< class List >
+List formGenWithoutRuns(const List &list, const FormGenRowRuns &runs)
+{
+    List kept;
+    kept.reserve(list.size() - formGenRunsSize(runs));
+    int row = 0;
+    for( const auto &run : runs ) {
+        for( ; row < run.first; ++row )
+            kept.append(list.at(row));
+        row = run.second;
+    }
+    for( ; row < list.size(); ++row )
+        kept.append(list.at(row));
+    return kept;
+}
+
+#endif // FORMGENWIDGETS_QT_ROWRUNS_P_H
@@ -0,0 +1,374 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "formgenschemabase.h"
+#include "formgenschemabase_p.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QRegularExpression>
+#include <QtAlgorithms>
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FORMGENWIDGETS_HAVE_SSE2
+#endif
+
+
+int formGenFindEscapeCharacter(const QChar *s, int from, int size)
+{
+    const ushort *data = reinterpret_cast<const ushort *>(s);
+    int i = from;
+
+    // a lane needs escaping if it is <= 0x1F (unsigned saturating subtract gives 0),
+    // a quote or a backslash
+#if defined(__AVX2__)
+    {
+        const __m256i maxControl = _mm256_set1_epi16(0x1F);
+        const __m256i quote = _mm256_set1_epi16(0x22);
+        const __m256i backslash = _mm256_set1_epi16(0x5C);
+        const __m256i zero = _mm256_setzero_si256();
+        for( ; i + 16 <= size; i += 16 ) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi16(_mm256_subs_epu16(v, maxControl), zero),
+                                                 _mm256_or_si256(_mm256_cmpeq_epi16(v, quote),
+                                                                 _mm256_cmpeq_epi16(v, backslash)));
+            const uint mask = static_cast<uint>(_mm256_movemask_epi8(hits));
+            if( mask )
+                return i + qCountTrailingZeroBits(mask) / 2;
+        }
+    }
+#endif
+#if defined(FORMGENWIDGETS_HAVE_SSE2)
+    {
+        const __m128i maxControl = _mm_set1_epi16(0x1F);
+        const __m128i quote = _mm_set1_epi16(0x22);
+        const __m128i backslash = _mm_set1_epi16(0x5C);
+        const __m128i zero = _mm_setzero_si128();
+        for( ; i + 8 <= size; i += 8 ) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            const __m128i hits = _mm_or_si128(_mm_cmpeq_epi16(_mm_subs_epu16(v, maxControl), zero),
+                                              _mm_or_si128(_mm_cmpeq_epi16(v, quote),
+                                                           _mm_cmpeq_epi16(v, backslash)));
+            const uint mask = static_cast<uint>(_mm_movemask_epi8(hits));
+            if( mask )
+                return i + qCountTrailingZeroBits(mask) / 2;
+        }
+    }
+#endif
+    for( ; i < size; ++i ) {
+        const ushort c = data[i];
+        if( c < 0x20 || c == 0x22 || c == 0x5C )
+            return i;
+    }
+    return size;
+}
+
+QString formGenJoinedPath(const QString &segment, const QString &subPath)
+{
+    if( subPath.isEmpty() )
+        return segment;
+
+    QString path;
+    path.reserve(segment.size() + 1 + subPath.size());
+    path.append(segment);
+    path.append(QLatin1Char('/'));
+    path.append(subPath);
+    return path;
+}
+
+
+FormGenAcceptResult FormGenAcceptResult::accept(QVariant value, const QString &valueString)
+{
+    return FormGenAcceptResult(true, {}, value, valueString);
+}
+
+FormGenAcceptResult FormGenAcceptResult::reject(QString path, QVariant value)
+{
+    return FormGenAcceptResult(false, path, value, {});
+}
+
+
+FormGenPath::FormGenPath(const QStringList &segments)
+    : mSegments(segments)
+{
+}
+
+FormGenPath FormGenPath::fromString(const QString &path)
+{
+    return FormGenPath(path.split(QLatin1Char('/'), QString::SkipEmptyParts));
+}
+
+QString FormGenPath::toString() const
+{
+    return mSegments.join(QLatin1Char('/'));
+}
+
+QStringList FormGenPath::segments() const
+{
+    return mSegments;
+}
+
+bool FormGenPath::isEmpty() const
+{
+    return mSegments.isEmpty();
+}
+
+int FormGenPath::size() const
+{
+    return mSegments.size();
+}
+
+QString FormGenPath::at(int i) const
+{
+    return mSegments.at(i);
+}
+
+FormGenPath FormGenPath::prepended(const QString &segment) const
+{
+    FormGenPath result(*this);
+    result.mSegments.prepend(segment);
+    return result;
+}
+
+FormGenPath FormGenPath::mid(int pos) const
+{
+    return FormGenPath(mSegments.mid(pos));
+}
+
+bool FormGenPath::operator==(const FormGenPath &other) const
+{
+    return mSegments == other.mSegments;
+}
+
+bool FormGenPath::operator!=(const FormGenPath &other) const
+{
+    return ! operator==(other);
+}
+
+uint qHash(const FormGenPath &path, uint seed)
+{
+    const QStringList segments = path.segments();
+    return qHashRange(segments.cbegin(), segments.cend(), seed);
+}
+
+
+QString FormGenSchemaBase::quotedString(const QString &s)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    const QChar *data = s.constData();
+    const int size = s.size();
+
+    // size the result up front, so it is allocated once
+    int resultSize = size + 2;
+    for( int i = formGenFindEscapeCharacter(data, 0, size); i < size;
+         i = formGenFindEscapeCharacter(data, i + 1, size) )
+        resultSize += data[i].unicode() < 0x20 ? 5 : 1;
+
+    QString result(resultSize, Qt::Uninitialized);
+    QChar *out = result.data();
+    *out++ = QLatin1Char('"');
+
+    int runStart = 0;
+    for( int i = formGenFindEscapeCharacter(data, 0, size); i < size;
+         i = formGenFindEscapeCharacter(data, i + 1, size) ) {
+        memcpy(out, data + runStart, (i - runStart) * sizeof(QChar));
+        out += i - runStart;
+        runStart = i + 1;
+
+        const ushort c = data[i].unicode();
+        *out++ = QLatin1Char('\\');
+        if( c < 0x20 ) {
+            *out++ = QLatin1Char('u');
+            *out++ = QLatin1Char('0');
+            *out++ = QLatin1Char('0');
+            *out++ = QLatin1Char(hexDigits[(c >> 4) & 15]);
+            *out++ = QLatin1Char(hexDigits[c & 15]);
+        } else {
+            *out++ = QChar(c);
+        }
+    }
+    memcpy(out, data + runStart, (size - runStart) * sizeof(QChar));
+    out += size - runStart;
+    *out = QLatin1Char('"');
+
+    return result;
+}
+
+// the strings keep the FormGenElement translation context they had as QWidget::tr calls
+QString FormGenSchemaBase::stringSet()
+{
+    return QCoreApplication::translate("FormGenElement", "set");
+}
+
+QString FormGenSchemaBase::stringUnset()
+{
+    return QCoreApplication::translate("FormGenElement", "unset");
+}
+
+QString FormGenSchemaBase::stringTrue()
+{
+    return QCoreApplication::translate("FormGenElement", "true");
+}
+
+QString FormGenSchemaBase::stringFalse()
+{
+    return QCoreApplication::translate("FormGenElement", "false");
+}
+
+const QRegularExpression *FormGenSchemaBase::tagPattern()
+{
+    static const QRegularExpression tagLiteral("\\A[^\\p{C}/]+\\z");
+
+    return &tagLiteral;
+}
+
+QString FormGenSchemaBase::joinedValueStringList(const QStringList &list)
+{
+    return QLatin1Char('[') + list.join(QStringLiteral(", ")) + QLatin1Char(']');
+}
+
+QString FormGenSchemaBase::keyStringValuePair(const QString &key, const QString &value)
+{
+    return quotedString(key) + QStringLiteral(": ") + value;
+}
+
+QString FormGenSchemaBase::objectString(const QStringList &keyStringValuePairs)
+{
+    return QLatin1Char('{') + keyStringValuePairs.join(QStringLiteral(", ")) + QLatin1Char('}');
+}
+
+QMetaType::Type FormGenSchemaBase::variantType(const QVariant &v)
+{
+    return static_cast<QMetaType::Type>(v.type());
+}
+
+static bool listRow(const QString &segment, int size, int *row)
+{
+    bool ok;
+    *row = segment.toInt(&ok);
+    return ok && *row >= 0 && *row < size;
+}
+
+QVariant FormGenSchemaBase::variantAt(const QVariant &v, const FormGenPath &path)
+{
+    QVariant current = v;
+
+    for( int i = 0; i < path.size(); ++i ) {
+        const QString segment = path.at(i);
+
+        if( variantType(current) == QMetaType::QVariantHash ) {
+            const QVariantHash &hash = formGenBorrowedHash(current);
+            const auto it = hash.constFind(segment);
+            if( it == hash.cend() )
+                return {};
+            const QVariant next = it.value();
+            current = next;
+        } else if( variantType(current) == QMetaType::QVariantList ) {
+            const QVariantList &list = formGenBorrowedList(current);
+            int row;
+            if( ! listRow(segment, list.size(), &row) )
+                return {};
+            const QVariant next = list.at(row);
+            current = next;
+        } else {
+            return {};
+        }
+    }
+
+    return current;
+}
+
+static bool setVariantAtPos(QVariant &v, const FormGenPath &path, int pos, const QVariant &subValue)
+{
+    if( pos == path.size() ) {
+        v = subValue;
+        return true;
+    }
+
+    const QString segment = path.at(pos);
+
+    if( FormGenSchemaBase::variantType(v) == QMetaType::QVariantHash ) {
+        QVariantHash hash = v.toHash();
+        const auto it = hash.find(segment);
+        if( it == hash.end() || ! setVariantAtPos(it.value(), path, pos + 1, subValue) )
+            return false;
+        v = hash;
+        return true;
+    }
+
+    if( FormGenSchemaBase::variantType(v) == QMetaType::QVariantList ) {
+        QVariantList list = v.toList();
+        int row;
+        if( ! listRow(segment, list.size(), &row) || ! setVariantAtPos(list[row], path, pos + 1, subValue) )
+            return false;
+        v = list;
+        return true;
+    }
+
+    return false;
+}
+
+bool FormGenSchemaBase::setVariantAt(QVariant &v, const FormGenPath &path, const QVariant &subValue)
+{
+    return setVariantAtPos(v, path, 0, subValue);
+}
+
+
+FormGenSchemaNode::FormGenSchemaNode(FormGenSchemaBase::ElementType type)
+    : mType(type)
+{
+}
+
+FormGenSchemaNode::~FormGenSchemaNode()
+{
+}
+
+FormGenSchemaBase::ElementType FormGenSchemaNode::elementType() const
+{
+    return mType;
+}
+
+FormGenAcceptResult FormGenSchemaNode::acceptsValue(const QVariant &val) const
+{
+    if (elementType() == Optional && ! val.isValid())
+        return FormGenAcceptResult::accept(val, stringUnset());
+
+    return acceptsValueImpl(val);
+}
+
+FormGenAcceptResult FormGenSchemaNode::validate(const QVariant &val) const
+{
+    if (elementType() == Optional && ! val.isValid())
+        return FormGenAcceptResult::accept(val, {});
+
+    return validateImpl(val);
+}
+
+FormGenAcceptResult FormGenSchemaNode::validateImpl(const QVariant &val) const
+{
+    FormGenAcceptResult result = acceptsValueImpl(val);
+    result.valueString.clear();
+    return result;
+}
@@ -0,0 +1,146 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMGENWIDGETS_QT_SCHEMABASE_H
+#define FORMGENWIDGETS_QT_SCHEMABASE_H
+
+#include <QMetaType>
+#include <QStringList>
+#include <QVariant>
+
+#include "formgenwidgets_global.h"
+
+class QRegularExpression;
+
+
+class FORMGENWIDGETS_CORE_EXPORT FormGenAcceptResult {
+public:
+    static FormGenAcceptResult accept(QVariant value, const QString &valueString);
+    static FormGenAcceptResult reject(QString path, QVariant value);
+
+    bool acceptable;
+    QString path;
+    QVariant value;
+    QString valueString;
+
+private:
+    FormGenAcceptResult(bool accept_, QString path_, QVariant value_, const QString &valueString_)
+        : acceptable(accept_)
+        , path(path_)
+        , value(value_)
+        , valueString(valueString_)
+    {}
+};
+
+
+/**
+ * Path of a sub value, consisting of record/choice tags and list/bag row
+ * numbers. The string form joins the segments with '/', e.g. "a/b/3/c",
+ * like the path of a rejected FormGenAcceptResult.
+ */
+class FORMGENWIDGETS_CORE_EXPORT FormGenPath {
+public:
+    FormGenPath() = default;
+    explicit FormGenPath(const QStringList &segments);
+
+    static FormGenPath fromString(const QString &path);
+    QString toString() const;
+
+    QStringList segments() const;
+    bool isEmpty() const;
+    int size() const;
+    QString at(int i) const;
+
+    FormGenPath prepended(const QString &segment) const;
+    FormGenPath mid(int pos) const;
+
+    bool operator==(const FormGenPath &other) const;
+    bool operator!=(const FormGenPath &other) const;
+
+private:
+    QStringList mSegments;
+};
+
+FORMGENWIDGETS_CORE_EXPORT uint qHash(const FormGenPath &path, uint seed = 0);
+
+Q_DECLARE_METATYPE(FormGenPath)
+
+
+/**
+ * Common definitions shared by the headless schema nodes and the widgets:
+ * the element type and the helpers producing the value string format.
+ */
+class FORMGENWIDGETS_CORE_EXPORT FormGenSchemaBase {
+public:
+    enum ElementType {
+        Required, Optional
+    };
+
+    static QString quotedString(const QString &s);
+    static const QRegularExpression *tagPattern();
+    static QString joinedValueStringList(const QStringList &list);
+    static QString keyStringValuePair(const QString &key, const QString &value);
+    static QString objectString(const QStringList &keyStringValuePairs);
+    static QMetaType::Type variantType(const QVariant &v);
+
+    /// Sub value of v addressed by path through nested hashes and lists, invalid if there is none.
+    static QVariant variantAt(const QVariant &v, const FormGenPath &path);
+    /// Replaces the existing sub value addressed by path, detaching only the containers along it.
+    static bool setVariantAt(QVariant &v, const FormGenPath &path, const QVariant &subValue);
+
+    static QString stringSet();
+    static QString stringUnset();
+    static QString stringTrue();
+    static QString stringFalse();
+};
+
+
+/**
+ * A schema node describes the set of values an element accepts, without any
+ * widget attached. Nodes only depend on QtCore, so they can be used to validate
+ * values without a QApplication. Every FormGenElement is a view over a node,
+ * see FormGenElement::schemaNode().
+ */
+class FORMGENWIDGETS_CORE_EXPORT FormGenSchemaNode : public FormGenSchemaBase {
+public:
+    explicit FormGenSchemaNode(ElementType type = Required);
+    virtual ~FormGenSchemaNode();
+
+    ElementType elementType() const;
+
+    FormGenAcceptResult acceptsValue(const QVariant &val) const;
+    /// Like acceptsValue, but only runs the structural and range checks: the
+    /// result carries the path of the first rejected sub value, but no value string.
+    FormGenAcceptResult validate(const QVariant &val) const;
+
+    virtual QVariant defaultValue() const = 0;
+
+protected:
+    /// acceptsValue or validate, for compositions that run either on their elements
+    typedef FormGenAcceptResult (FormGenSchemaNode::*Check)(const QVariant &val) const;
+
+    virtual FormGenAcceptResult acceptsValueImpl(const QVariant &val) const = 0;
+    virtual FormGenAcceptResult validateImpl(const QVariant &val) const;
+
+private:
+    Q_DISABLE_COPY(FormGenSchemaNode)
+
+    ElementType mType;
+};
+
+#endif // FORMGENWIDGETS_QT_SCHEMABASE_H
@@ -0,0 +1,47 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMGENWIDGETS_QT_SCHEMABASE_P_H
+#define FORMGENWIDGETS_QT_SCHEMABASE_P_H
+
+#include <QChar>
+#include <QVariant>
+
+
+// Index of the first character at or after from that the value string format
+// escapes (control chars, quote and backslash), or size if there is none.
+int formGenFindEscapeCharacter(const QChar *data, int from, int size);
+
+// Joins a path segment and a possibly empty sub path, allocating once.
+QString formGenJoinedPath(const QString &segment, const QString &subPath);
+
+// The container held by a variant of the matching type, read in place instead
+// of copied out by toHash()/toList().
+inline const QVariantHash &formGenBorrowedHash(const QVariant &val)
+{
+    Q_ASSERT(val.userType() == QMetaType::QVariantHash);
+    return *static_cast<const QVariantHash *>(val.constData());
+}
+
+inline const QVariantList &formGenBorrowedList(const QVariant &val)
+{
+    Q_ASSERT(val.userType() == QMetaType::QVariantList);
+    return *static_cast<const QVariantList *>(val.constData());
+}
+
+#endif // FORMGENWIDGETS_QT_SCHEMABASE_P_H
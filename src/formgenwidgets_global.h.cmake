@@ -10,10 +10,18 @@
 #if ${FORMGENWIDGETS_STATIC}
  // static lib
  #define FORMGENWIDGETS_EXPORT
-#elif defined(FORMGENWIDGETS_LIBRARY)
- #define FORMGENWIDGETS_EXPORT Q_DECL_EXPORT
+ #define FORMGENWIDGETS_CORE_EXPORT
 #else
- #define FORMGENWIDGETS_EXPORT Q_DECL_IMPORT
+ #if defined(FORMGENWIDGETS_LIBRARY)
+  #define FORMGENWIDGETS_EXPORT Q_DECL_EXPORT
+ #else
+  #define FORMGENWIDGETS_EXPORT Q_DECL_IMPORT
+ #endif
+ #if defined(FORMGENWIDGETS_CORE_LIBRARY)
+  #define FORMGENWIDGETS_CORE_EXPORT Q_DECL_EXPORT
+ #else
+  #define FORMGENWIDGETS_CORE_EXPORT Q_DECL_IMPORT
+ #endif
 #endif
 
 #endif // FORMGENWIDGETS_GLOBAL_H
@@ -21,26 +21,32 @@
 #include <QCheckBox>
 #include <QGroupBox>
 #include <QHBoxLayout>
-#include <QRegularExpression>
+#include <QMetaMethod>
 
 
-FormGenAcceptResult FormGenAcceptResult::accept(QVariant value, const QString &valueString)
-{
-    return FormGenAcceptResult(true, {}, value, valueString);
-}
-
-FormGenAcceptResult FormGenAcceptResult::reject(QString path, QVariant value)
-{
-    return FormGenAcceptResult(false, path, value, {});
-}
+// batches open anywhere; without any, changes need not look for a batching ancestor
+static int s_openBatches = 0;
 
 
 FormGenElement::FormGenElement(FormGenElement::ElementType type, QWidget *parent)
     : QWidget(parent)
     , mType(type)
     , mValueSet(type == Required)
+    , mEmittingSubValueChange(false)
+    , mValueCacheValid(false)
+    , mValueStringCacheValid(false)
+    , mBatchDepth(0)
+    , mBatchWholeChanged(false)
+    , mBatchDeferred(false)
+    , mEmitsThroughBatches(false)
 {
-    connect(this, &FormGenElement::valueSetChanged, this, &FormGenElement::valueChanged);
+    qRegisterMetaType<FormGenPath>();
+    qRegisterMetaType< QList<FormGenPath> >();
+
+    // connected first, so every other receiver of valueChanged sees the new value
+    connect(this, &FormGenElement::valueChanged, this, &FormGenElement::invalidateCaches);
+    connect(this, &FormGenElement::valueChanged, this, &FormGenElement::emitWholeValueChanged);
+    connect(this, &FormGenElement::valueSetChanged, this, &FormGenElement::notifyValueChanged);
 }
 
 FormGenElement::ElementType FormGenElement::elementType() const
@@ -53,7 +59,11 @@ QVariant FormGenElement::value() const
     if( ! isValueSet() )
         return {};
 
-    return valueImpl();
+    if( ! mValueCacheValid ) {
+        mValueCache = valueImpl();
+        mValueCacheValid = true;
+    }
+    return mValueCache;
 }
 
 QString FormGenElement::valueString() const
@@ -61,25 +71,83 @@ QString FormGenElement::valueString() const
     if( ! isValueSet() )
         return stringUnset();
 
-    return valueStringImpl();
+    if( ! mValueStringCacheValid ) {
+        mValueStringCache = valueStringImpl();
+        mValueStringCacheValid = true;
+    }
+    return mValueStringCache;
+}
+
+void FormGenElement::writeValueString(FormGenWriter &writer) const
+{
+    if( ! isValueSet() ) {
+        writer.writeValue(stringUnset());
+        return;
+    }
+
+    if( mValueStringCacheValid ) {
+        writer.writeValue(mValueStringCache);
+        return;
+    }
+
+    writeValueStringImpl(writer);
 }
 
 FormGenAcceptResult FormGenElement::acceptsValue(const QVariant &val) const
 {
-    if (elementType() == Optional && ! val.isValid())
-        return FormGenAcceptResult::accept(val, stringUnset());
+    return schemaNode()->acceptsValue(val);
+}
 
-    return acceptsValueImpl(val);
+FormGenAcceptResult FormGenElement::validate(const QVariant &val) const
+{
+    return schemaNode()->validate(val);
 }
 
 void FormGenElement::setValue(const QVariant &val)
 {
-    if( ! acceptsValue(val).acceptable )
+    if( ! validate(val).acceptable )
         return;
 
     setValidatedValue(val);
 }
 
+QVariant FormGenElement::valueAt(const FormGenPath &path) const
+{
+    if( path.isEmpty() )
+        return value();
+
+    if( ! isValueSet() )
+        return {};
+
+    return valueAtImpl(path);
+}
+
+QVariant FormGenElement::valueAt(const QString &path) const
+{
+    return valueAt(FormGenPath::fromString(path));
+}
+
+bool FormGenElement::setValueAt(const FormGenPath &path, const QVariant &val)
+{
+    if( path.isEmpty() ) {
+        if( ! validate(val).acceptable )
+            return false;
+
+        setValidatedValue(val);
+        return true;
+    }
+
+    if( ! isValueSet() )
+        return false;
+
+    return setValueAtImpl(path, val);
+}
+
+bool FormGenElement::setValueAt(const QString &path, const QVariant &val)
+{
+    return setValueAt(FormGenPath::fromString(path), val);
+}
+
 void FormGenElement::setValidatedValue(const QVariant &val)
 {
     if( ! val.isValid() ) {
@@ -90,102 +158,214 @@ void FormGenElement::setValidatedValue(const QVariant &val)
     }
 }
 
+QVariant FormGenElement::defaultValue() const
+{
+    return schemaNode()->defaultValue();
+}
+
 QGroupBox *FormGenElement::frameWidget() const
 {
     return nullptr;
 }
 
+QVariant FormGenElement::valueAtImpl(const FormGenPath &path) const
+{
+    return variantAt(value(), path);
+}
+
+bool FormGenElement::setValueAtImpl(const FormGenPath &path, const QVariant &val)
+{
+    QVariant newValue = value();
+    if( ! setVariantAt(newValue, path, val) || ! validate(newValue).acceptable )
+        return false;
+
+    setValidatedValue(newValue);
+    return true;
+}
+
+void FormGenElement::writeValueStringImpl(FormGenWriter &writer) const
+{
+    writer.writeValue(valueStringImpl());
+}
+
 bool FormGenElement::isValueSet() const
 {
     return mValueSet;
 }
 
-void FormGenElement::setValueSet(bool valueSet)
+void FormGenElement::emitSubValueChanged(const FormGenPath &path, const QVariant &newSubValue)
 {
-    if (mValueSet == valueSet)
+    invalidateCaches();
+
+    if( mBatchDepth > 0 || deferToBatchingAncestor() ) {
+        if( ! mBatchPathSet.contains(path) ) {
+            mBatchPathSet.insert(path);
+            mBatchPaths.append(path);
+        }
+        if( mBatchPaths.size() == 1 )
+            mBatchSubValue = newSubValue;
         return;
+    }
 
-    mValueSet = valueSet;
-    emit valueSetChanged(mValueSet);
+    emitValueChangedAt(path, newSubValue);
 }
 
-
-QString FormGenElement::quotedString(const QString &s)
-{
-    QString result;
-    for(int i=0; i < s.size(); ++i) {
-        int tmp = s.at(i).unicode();
-        if( tmp < 0x20) {
-            result += QString("\\u00");
-            char c = (tmp>>4) & 15;
-            if( c < 10 )
-                result += QChar(static_cast<char>(c + 0x30));
-            else
-                result += QChar(static_cast<char>(c + 0x37));
-            c = tmp & 15;
-            if( c < 10 )
-                result += QChar(static_cast<char>(c + 0x30));
-            else
-                result += QChar(static_cast<char>(c + 0x37));
-        }
-        else if( tmp == 0x22 ) {
-            result += QString("\\\"");
-        }
-        else if( tmp == 0x5C ) {
-            result += QString("\\\\");
-        }
-        else {
-            result += s.at(i);
-        }
+void FormGenElement::notifyValueChanged()
+{
+    if( mBatchDepth > 0 || deferToBatchingAncestor() ) {
+        invalidateCaches();
+        mBatchWholeChanged = true;
+        return;
     }
-    return QString("\"%1\"").arg(result);
+
+    emit valueChanged();
 }
 
-QString FormGenElement::stringSet()
+void FormGenElement::beginUpdateBatch()
 {
-    return tr("set");
+    ++mBatchDepth;
 }
 
-QString FormGenElement::stringUnset()
+void FormGenElement::endUpdateBatch()
 {
-    return tr("unset");
+    Q_ASSERT(mBatchDepth > 0);
+    // while still open, so the changes held back below are recorded here
+    if( mBatchDepth == 1 )
+        flushDeferredBatches();
+    if( --mBatchDepth > 0 )
+        return;
+
+    if( ! mBatchWholeChanged && mBatchPaths.isEmpty() )
+        return;
+
+    if( ! deferToBatchingAncestor() )
+        emitBatchedChanges();
 }
 
-QString FormGenElement::stringTrue()
+bool FormGenElement::deferToBatchingAncestor()
 {
-    return tr("true");
+    if( s_openBatches == 0 )
+        return false;
+
+    FormGenElement *ancestor = this;
+    int depth = 0;
+    do {
+        if( ancestor->mEmitsThroughBatches )
+            return false;
+
+        QWidget *widget = ancestor->parentWidget();
+        ancestor = nullptr;
+        for( ; widget && ! ancestor; widget = widget->parentWidget() )
+            ancestor = qobject_cast<FormGenElement *>(widget);
+        if( ! ancestor )
+            return false;
+        ++depth;
+    } while( ancestor->mBatchDepth == 0 );
+
+    // the values up to the ancestor contain this one
+    for( QWidget *widget = parentWidget(); widget != ancestor; widget = widget->parentWidget() ) {
+        if( auto * element = qobject_cast<FormGenElement *>(widget) )
+            element->invalidateCaches();
+    }
+    ancestor->invalidateCaches();
+
+    if( ! mBatchDeferred ) {
+        mBatchDeferred = true;
+        ancestor->mBatchDeferredElements.insert(depth, this);
+    }
+    return true;
 }
 
-QString FormGenElement::stringFalse()
+void FormGenElement::flushDeferredBatches()
 {
-    return tr("false");
+    // deepest first, so each element forwards the changes of its descendants in one go
+    while( ! mBatchDeferredElements.isEmpty() ) {
+        auto deepest = mBatchDeferredElements.end();
+        --deepest;
+        const QPointer<FormGenElement> element = deepest.value();
+        mBatchDeferredElements.erase(deepest);
+        if( element )
+            element->emitBatchedChanges();
+    }
 }
 
-const QRegularExpression *FormGenElement::tagPattern()
+void FormGenElement::emitBatchedChanges()
 {
-    static const QRegularExpression tagLiteral("\\A[^\\p{C}/]+\\z");
+    mBatchDeferred = false;
+    if( ! mBatchWholeChanged && mBatchPaths.isEmpty() )
+        return;
 
-    return &tagLiteral;
+    QList<FormGenPath> changedPaths;
+    if( mBatchWholeChanged )
+        changedPaths.append(FormGenPath());
+    else
+        changedPaths.swap(mBatchPaths);
+    const QVariant subValue = mBatchSubValue;
+    mBatchPaths.clear();
+    mBatchPathSet.clear();
+    mBatchSubValue = QVariant();
+    mBatchWholeChanged = false;
+
+    emit batchValueChanged(changedPaths);
+
+    // a single change is forwarded with its path, several as one whole-value change
+    if( changedPaths.size() == 1 && ! changedPaths.first().isEmpty() )
+        emitValueChangedAt(changedPaths.first(), subValue);
+    else
+        emit valueChanged();
 }
 
-QString FormGenElement::joinedValueStringList(const QStringList &list)
+void FormGenElement::emitValueChangedAt(const FormGenPath &path, const QVariant &newSubValue)
 {
-    return QString("[%1]").arg(list.join(QStringLiteral(", ")));
+    mEmittingSubValueChange = true;
+    emit valueChangedAt(path, newSubValue);
+    emit valueChanged();
+    mEmittingSubValueChange = false;
 }
 
-QString FormGenElement::keyStringValuePair(const QString &key, const QString &value)
+void FormGenElement::invalidateCaches()
 {
-    return QString("%1: %2").arg(quotedString(key), value);
+    mValueCacheValid = false;
+    mValueCache = QVariant();
+    mValueStringCacheValid = false;
+    mValueStringCache.clear();
 }
 
-QString FormGenElement::objectString(const QStringList &keyStringValuePairs)
+void FormGenElement::emitWholeValueChanged()
+{
+    if( mEmittingSubValueChange )
+        return;
+
+    static const QMetaMethod valueChangedAtSignal = QMetaMethod::fromSignal(&FormGenElement::valueChangedAt);
+    if( ! isSignalConnected(valueChangedAtSignal) )
+        return;
+
+    emit valueChangedAt(FormGenPath(), value());
+}
+
+void FormGenElement::setValueSet(bool valueSet)
+{
+    if (mValueSet == valueSet)
+        return;
+
+    mValueSet = valueSet;
+    emit valueSetChanged(mValueSet);
+}
+
+
+FormGenUpdateBatch::FormGenUpdateBatch(FormGenElement *element)
+    : mElement(element)
 {
-    return QString("{%1}").arg(keyStringValuePairs.join(QStringLiteral(", ")));
+    Q_ASSERT(element);
+    ++s_openBatches;
+    mElement->beginUpdateBatch();
 }
 
-QMetaType::Type FormGenElement::variantType(const QVariant &v)
+FormGenUpdateBatch::~FormGenUpdateBatch()
 {
-    return static_cast<QMetaType::Type>(v.type());
+    if( mElement )
+        mElement->endUpdateBatch();
+    --s_openBatches;
 }
 
 
@@ -19,6 +19,12 @@
 #ifndef FORMGENWIDGETS_QT_BASE_H
 #define FORMGENWIDGETS_QT_BASE_H
 
+#include "formgenschemabase.h"
+#include "formgenwriter.h"
+
+#include <QMultiMap>
+#include <QPointer>
+#include <QSet>
 #include <QVariant>
 #include <QWidget>
 
@@ -29,74 +35,66 @@ class QGroupBox;
 class QHBoxLayout;
 
 
-class FORMGENWIDGETS_EXPORT FormGenAcceptResult {
-public:
-    static FormGenAcceptResult accept(QVariant value, const QString &valueString);
-    static FormGenAcceptResult reject(QString path, QVariant value);
-
-    bool acceptable;
-    QString path;
-    QVariant value;
-    QString valueString;
-
-private:
-    FormGenAcceptResult(bool accept_, QString path_, QVariant value_, const QString &valueString_)
-        : acceptable(accept_)
-        , path(path_)
-        , value(value_)
-        , valueString(valueString_)
-    {}
-};
-
-
-class FORMGENWIDGETS_EXPORT FormGenElement : public QWidget {
+class FORMGENWIDGETS_EXPORT FormGenElement : public QWidget, public FormGenSchemaBase {
     Q_OBJECT
     Q_PROPERTY(QVariant value READ value WRITE setValue NOTIFY valueChanged)
 
 public:
-    enum ElementType {
-        Required, Optional
-    };
-
     explicit FormGenElement(ElementType type = Required, QWidget * parent = nullptr);
 
     ElementType elementType() const;
 
+    /// The value and value string are cached until the next valueChanged, so compositions
+    /// reuse the (implicitly shared) results of unchanged children and only rebuild along
+    /// the changed path.
     QVariant value() const;
     QString valueString() const;
+    /// Streams the value string, without building the strings of the nested levels.
+    void writeValueString(FormGenWriter &writer) const;
     FormGenAcceptResult acceptsValue(const QVariant &val) const;
+    FormGenAcceptResult validate(const QVariant &val) const;
     void setValue(const QVariant &val);
 
-    virtual QVariant defaultValue() const = 0;
+    /// Sub value addressed by path ("a/b/3/c", as in FormGenAcceptResult::path), invalid if there is none.
+    QVariant valueAt(const FormGenPath &path) const;
+    QVariant valueAt(const QString &path) const;
+    /// Validates and applies val to the addressed sub value only; returns false if it was rejected.
+    bool setValueAt(const FormGenPath &path, const QVariant &val);
+    bool setValueAt(const QString &path, const QVariant &val);
 
-    virtual QGroupBox *frameWidget() const;
+    virtual QVariant defaultValue() const;
 
-    static QString quotedString(const QString &s);
-    static const QRegularExpression *tagPattern();
-    static QString joinedValueStringList(const QStringList &list);
-    static QString keyStringValuePair(const QString &key, const QString &value);
-    static QString objectString(const QStringList &keyStringValuePairs);
-    static QMetaType::Type variantType(const QVariant &v);
+    /// The headless schema node this element is a view over, used for validation.
+    virtual const FormGenSchemaNode *schemaNode() const = 0;
 
-    static QString stringSet();
-    static QString stringUnset();
-    static QString stringTrue();
-    static QString stringFalse();
+    virtual QGroupBox *frameWidget() const;
 
 signals:
     void valueChanged();
     void valueSetChanged(bool isSet);
+    /// Emitted along with valueChanged; path is empty if the whole value changed.
+    void valueChangedAt(const FormGenPath &path, const QVariant &newSubValue);
+    /// Emitted before the coalesced valueChanged at the end of an update batch on this element or an ancestor.
+    void batchValueChanged(const QList<FormGenPath> &changedPaths);
 
 protected:
     bool isValueSet() const;
 
     virtual QVariant valueImpl() const = 0;
     virtual QString valueStringImpl() const = 0;
-    virtual FormGenAcceptResult acceptsValueImpl(const QVariant &val) const = 0;
+    virtual void writeValueStringImpl(FormGenWriter &writer) const;
 
     void setValidatedValue(const QVariant &val);
     virtual void setVaidatedValueImpl(const QVariant &val) = 0;
 
+    // path is nonempty and the value is set
+    virtual QVariant valueAtImpl(const FormGenPath &path) const;
+    virtual bool setValueAtImpl(const FormGenPath &path, const QVariant &val);
+
+    /// Emits valueChangedAt for the changed sub value, then valueChanged; during an
+    /// update batch the path is recorded instead.
+    void emitSubValueChanged(const FormGenPath &path, const QVariant &newSubValue);
+
     struct CompositionElement {
         CompositionElement(const QString &_tag = QString(), FormGenElement *_element = nullptr)
             : tag(_tag)
@@ -109,10 +107,39 @@ protected:
 
 protected slots:
      void setValueSet(bool valueSet);
+     /// Emits valueChanged for a whole-value change, or records it during an update batch.
+     void notifyValueChanged();
+
+private slots:
+    void invalidateCaches();
+    void emitWholeValueChanged();
 
 private:
     ElementType mType;
     bool mValueSet;
+    bool mEmittingSubValueChange;
+    mutable QVariant mValueCache;
+    mutable bool mValueCacheValid;
+    mutable QString mValueStringCache;
+    mutable bool mValueStringCacheValid;
+    int mBatchDepth;
+    bool mBatchWholeChanged;
+    bool mBatchDeferred;
+    bool mEmitsThroughBatches;
+    QList<FormGenPath> mBatchPaths;
+    QSet<FormGenPath> mBatchPathSet;
+    QVariant mBatchSubValue;
+    // descendants holding back their changes for this element's batch, by depth below it
+    QMultiMap< int, QPointer<FormGenElement> > mBatchDeferredElements;
+
+    void beginUpdateBatch();
+    void endUpdateBatch();
+    bool deferToBatchingAncestor();
+    void flushDeferredBatches();
+    void emitBatchedChanges();
+    void emitValueChangedAt(const FormGenPath &path, const QVariant &newSubValue);
+
+    friend class FormGenUpdateBatch;
 
     friend class FormGenRecordComposition;
     friend class FormGenChoiceComposition;
@@ -120,6 +147,26 @@ private:
 };
 
 
+/**
+ * Suspends the change notifications of an element while in scope. Changes made
+ * meanwhile anywhere in its subtree are coalesced into a single valueChanged,
+ * preceded by batchValueChanged listing the changed paths, when the outermost
+ * batch on the element ends. The descendants hold back their own notifications
+ * until then too, except for the content editor of a list or bag, whose rows
+ * follow its edits.
+ */
+class FORMGENWIDGETS_EXPORT FormGenUpdateBatch {
+public:
+    explicit FormGenUpdateBatch(FormGenElement * element);
+    ~FormGenUpdateBatch();
+
+private:
+    Q_DISABLE_COPY(FormGenUpdateBatch)
+
+    QPointer<FormGenElement> mElement;
+};
+
+
 class FORMGENWIDGETS_EXPORT FormGenUnframedBase : public FormGenElement {
     Q_OBJECT
 
@@ -0,0 +1,153 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "formgenwriter.h"
+#include "formgenschemabase_p.h"
+
+#include <QTextStream>
+
+
+FormGenWriter::FormGenWriter(QTextStream *stream)
+    : mStream(stream)
+    , mOwnsStream(false)
+    , mAfterKey(false)
+{
+}
+
+FormGenWriter::FormGenWriter(QIODevice *device)
+    : mStream(new QTextStream(device))
+    , mOwnsStream(true)
+    , mAfterKey(false)
+{
+    mStream->setCodec("UTF-8");
+}
+
+FormGenWriter::FormGenWriter(QString *buffer)
+    : mStream(new QTextStream(buffer, QIODevice::WriteOnly | QIODevice::Append))
+    , mOwnsStream(true)
+    , mAfterKey(false)
+{
+}
+
+FormGenWriter::~FormGenWriter()
+{
+    mStream->flush();
+    if( mOwnsStream )
+        delete mStream;
+}
+
+void FormGenWriter::beginObject()
+{
+    writeSeparator();
+    *mStream << QLatin1Char('{');
+    mFirstInLevel.append(true);
+}
+
+void FormGenWriter::writeKey(const QString &key)
+{
+    writeSeparator();
+    writeQuoted(key);
+    *mStream << QLatin1String(": ");
+    mAfterKey = true;
+}
+
+void FormGenWriter::endObject()
+{
+    Q_ASSERT(! mFirstInLevel.isEmpty());
+    mFirstInLevel.removeLast();
+    *mStream << QLatin1Char('}');
+}
+
+void FormGenWriter::beginList()
+{
+    writeSeparator();
+    *mStream << QLatin1Char('[');
+    mFirstInLevel.append(true);
+}
+
+void FormGenWriter::endList()
+{
+    Q_ASSERT(! mFirstInLevel.isEmpty());
+    mFirstInLevel.removeLast();
+    *mStream << QLatin1Char(']');
+}
+
+void FormGenWriter::writeValue(const QString &valueString)
+{
+    writeSeparator();
+    *mStream << valueString;
+}
+
+void FormGenWriter::writeQuotedString(const QString &s)
+{
+    writeSeparator();
+    writeQuoted(s);
+}
+
+void FormGenWriter::flush()
+{
+    mStream->flush();
+}
+
+void FormGenWriter::writeQuoted(const QString &s)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    *mStream << QLatin1Char('"');
+
+    // write the runs between characters needing an escape without copying them
+    const QChar *data = s.constData();
+    const int size = s.size();
+    int runStart = 0;
+    for( int i = formGenFindEscapeCharacter(data, 0, size); i < size;
+         i = formGenFindEscapeCharacter(data, i + 1, size) ) {
+        const ushort c = data[i].unicode();
+
+        if( i > runStart )
+            *mStream << QString::fromRawData(data + runStart, i - runStart);
+        runStart = i + 1;
+
+        if( c < 0x20 ) {
+            *mStream << QLatin1String("\\u00")
+                     << QLatin1Char(hexDigits[(c >> 4) & 15])
+                     << QLatin1Char(hexDigits[c & 15]);
+        } else {
+            *mStream << QLatin1Char('\\') << QLatin1Char(static_cast<char>(c));
+        }
+    }
+    if( runStart < size )
+        *mStream << QString::fromRawData(data + runStart, size - runStart);
+
+    *mStream << QLatin1Char('"');
+}
+
+void FormGenWriter::writeSeparator()
+{
+    if( mAfterKey ) {
+        mAfterKey = false;
+        return;
+    }
+
+    if( mFirstInLevel.isEmpty() )
+        return;
+
+    if( mFirstInLevel.last() )
+        mFirstInLevel.last() = false;
+    else
+        *mStream << QLatin1String(", ");
+}
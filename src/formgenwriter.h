@@ -0,0 +1,69 @@
+/* Copyright 2014, 2015 Zeno Sebastian Endemann <zeno.endemann@googlemail.com>
+ *
+ * This file is part of FormGenWidgets-Qt.
+ *
+ * FormGenWidgets-Qt is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FormGenWidgets-Qt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FormGenWidgets-Qt.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMGENWIDGETS_QT_WRITER_H
+#define FORMGENWIDGETS_QT_WRITER_H
+
+#include <QString>
+#include <QVector>
+
+#include "formgenwidgets_global.h"
+
+class QIODevice;
+class QTextStream;
+
+
+/**
+ * Streams the value string format token by token into a QTextStream, a
+ * QIODevice (as UTF-8) or a QString buffer, inserting the ", " separators
+ * itself. This avoids building the intermediate strings of every nesting
+ * level that valueString() needs.
+ */
+class FORMGENWIDGETS_CORE_EXPORT FormGenWriter {
+public:
+    explicit FormGenWriter(QTextStream * stream);
+    explicit FormGenWriter(QIODevice * device);
+    explicit FormGenWriter(QString * buffer);
+    ~FormGenWriter();
+
+    void beginObject();
+    void writeKey(const QString &key);
+    void endObject();
+
+    void beginList();
+    void endList();
+
+    /// Writes an already rendered value string, e.g. of a leaf element.
+    void writeValue(const QString &valueString);
+    void writeQuotedString(const QString &s);
+
+    void flush();
+
+private:
+    Q_DISABLE_COPY(FormGenWriter)
+
+    void writeSeparator();
+    void writeQuoted(const QString &s);
+
+    QTextStream *mStream;
+    bool mOwnsStream;
+    bool mAfterKey;
+    QVector<bool> mFirstInLevel;
+};
+
+#endif // FORMGENWIDGETS_QT_WRITER_H
@@ -0,0 +1,41 @@
+#ifndef FORMGENWIDGETS_QT_BENCHMARK_H
+#define FORMGENWIDGETS_QT_BENCHMARK_H
+
+#include <QApplication>
+#include <QtTest>
+
+// Sizes are configurable through the environment, e.g. FORMGENWIDGETS_BENCH_MAX_ROWS=100000
+inline int benchmarkSetting(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue((QByteArray("FORMGENWIDGETS_BENCH_") + name).constData(), &ok);
+    return ok && value > 0 ? value : defaultValue;
+}
+
+// Adds the data rows "10k", "100k" and "1M" (up to FORMGENWIDGETS_BENCH_MAX_ROWS) for an int column "rows".
+inline void addRowCounts()
+{
+    QTest::addColumn<int>("rows");
+
+    const int maxRows = benchmarkSetting("MAX_ROWS", 1000000);
+    const struct { const char *tag; int rows; } counts[] = {
+        { "10k", 10000 }, { "100k", 100000 }, { "1M", 1000000 }
+    };
+    for( const auto &count : counts ) {
+        if( count.rows <= maxRows )
+            QTest::newRow(count.tag) << count.rows;
+    }
+}
+
+// Like QTEST_MAIN, but defaults to the offscreen platform so no display is needed.
+#define FORMGEN_BENCHMARK_MAIN(TestObject) \
+int main(int argc, char *argv[]) \
+{ \
+    if( qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") ) \
+        qputenv("QT_QPA_PLATFORM", "offscreen"); \
+    QApplication app(argc, argv); \
+    TestObject tc; \
+    return QTest::qExec(&tc, argc, argv); \
+}
+
+#endif // FORMGENWIDGETS_QT_BENCHMARK_H
@@ -0,0 +1,355 @@
+#include "benchmark.h"
+#include "formgenwidgets-qt-core.h"
+#include "formgenwidgets-qt.h"
+
+#include <QScopedPointer>
+
+// Generated forms: records of FORM_WIDTH leaves (ints, texts, bools, floats and int lists)
+// with FORM_BRANCHES nested records each, FORM_DEPTH levels deep.
+class FormsBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void construct();
+    void acceptsValue();
+    void validate();
+    void setValue();
+    void setValueAt();
+    void valueString();
+    void writeValueString();
+
+    void schemaAcceptsValue();
+    void schemaValidate();
+
+    void quotedString_data();
+    void quotedString();
+    void quotedStringScalar_data() { quotedString_data(); }
+    void quotedStringScalar();
+    void fileUrlListSetValue_data();
+    void fileUrlListSetValue();
+    void fileUrlListValueString_data();
+    void fileUrlListValueString();
+
+private:
+    FormGenElement *createForm(int depth) const;
+    FormGenSchemaNode *createSchema(int depth) const;
+    QVariant createValue(int depth, int seed) const;
+    static QVariantList urls(int rows);
+    static QString quotedStringInput(int length, int escapeEvery);
+    static QString scalarQuotedString(const QString &s);
+
+    int mWidth;
+    int mBranches;
+    int mDepth;
+    int mListRows;
+    QVariant mValue;
+    QVariant mOtherValue;
+    QString mLeafPath;
+};
+
+void FormsBenchmark::initTestCase()
+{
+    mWidth = benchmarkSetting("FORM_WIDTH", 8);
+    mBranches = benchmarkSetting("FORM_BRANCHES", 2);
+    mDepth = benchmarkSetting("FORM_DEPTH", 3);
+    mListRows = benchmarkSetting("FORM_LIST_ROWS", 16);
+    mValue = createValue(mDepth, 0);
+    mOtherValue = createValue(mDepth, 1);
+
+    mLeafPath = QStringLiteral("f0");
+    for( int d = 0; d < mDepth; ++d )
+        mLeafPath.prepend(QStringLiteral("r0/"));
+
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    QVERIFY(form->acceptsValue(mValue).acceptable);
+    QVERIFY(form->acceptsValue(mOtherValue).acceptable);
+}
+
+FormGenElement *FormsBenchmark::createForm(int depth) const
+{
+    auto * record = new FormGenRecordComposition;
+    for( int i = 0; i < mWidth; ++i ) {
+        const QString tag = QStringLiteral("f%1").arg(i);
+        switch( i % 5 ) {
+        case 0: record->addElement(tag, new FormGenIntWidget); break;
+        case 1: record->addElement(tag, new FormGenTextWidget); break;
+        case 2: record->addElement(tag, new FormGenBoolWidget); break;
+        case 3: record->addElement(tag, new FormGenFloatWidget); break;
+        default: {
+            auto * list = new FormGenListBagComposition(FormGenListBagComposition::ListMode);
+            list->setContentElement(new FormGenIntWidget);
+            record->addElement(tag, list);
+            break;
+        }
+        }
+    }
+    if( depth > 0 ) {
+        for( int b = 0; b < mBranches; ++b )
+            record->addElement(QStringLiteral("r%1").arg(b), createForm(depth - 1));
+    }
+    return record;
+}
+
+FormGenSchemaNode *FormsBenchmark::createSchema(int depth) const
+{
+    auto * record = new FormGenRecordNode;
+    for( int i = 0; i < mWidth; ++i ) {
+        const QString tag = QStringLiteral("f%1").arg(i);
+        switch( i % 5 ) {
+        case 0: record->addElement(tag, new FormGenIntNode); break;
+        case 1: record->addElement(tag, new FormGenTextNode); break;
+        case 2: record->addElement(tag, new FormGenBoolNode); break;
+        case 3: record->addElement(tag, new FormGenFloatNode); break;
+        default: {
+            auto * list = new FormGenListBagNode(FormGenListBagNode::ListMode);
+            list->setContentElement(new FormGenIntNode);
+            record->addElement(tag, list);
+            break;
+        }
+        }
+    }
+    if( depth > 0 ) {
+        for( int b = 0; b < mBranches; ++b )
+            record->addElement(QStringLiteral("r%1").arg(b), createSchema(depth - 1));
+    }
+    return record;
+}
+
+QVariant FormsBenchmark::createValue(int depth, int seed) const
+{
+    QVariantHash hash;
+    for( int i = 0; i < mWidth; ++i ) {
+        const QString tag = QStringLiteral("f%1").arg(i);
+        const int x = (i + seed) % 100;
+        switch( i % 5 ) {
+        case 0: hash.insert(tag, x); break;
+        case 1: hash.insert(tag, QStringLiteral("text \"%1\"").arg(x)); break;
+        case 2: hash.insert(tag, x % 2 == 0); break;
+        case 3: hash.insert(tag, x / 8.0); break;
+        default: {
+            QVariantList list;
+            for( int r = 0; r < mListRows; ++r )
+                list.append((r * 7 + seed) % 100);
+            hash.insert(tag, list);
+            break;
+        }
+        }
+    }
+    if( depth > 0 ) {
+        for( int b = 0; b < mBranches; ++b )
+            hash.insert(QStringLiteral("r%1").arg(b), createValue(depth - 1, seed + b));
+    }
+    return hash;
+}
+
+QVariantList FormsBenchmark::urls(int rows)
+{
+    QVariantList list;
+    list.reserve(rows);
+    for( int i = 0; i < rows; ++i )
+        list.append(QStringLiteral("file:///home/user/documents/project \"%1\"/report.txt").arg(i));
+    return list;
+}
+
+void FormsBenchmark::construct()
+{
+    QBENCHMARK {
+        QScopedPointer<FormGenElement> form(createForm(mDepth));
+    }
+}
+
+void FormsBenchmark::acceptsValue()
+{
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    QBENCHMARK {
+        form->acceptsValue(mValue);
+    }
+}
+
+void FormsBenchmark::validate()
+{
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    QBENCHMARK {
+        form->validate(mValue);
+    }
+}
+
+void FormsBenchmark::setValue()
+{
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    bool other = false;
+    QBENCHMARK {
+        form->setValue(other ? mOtherValue : mValue);
+        other = ! other;
+    }
+}
+
+void FormsBenchmark::setValueAt()
+{
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    form->setValue(mValue);
+    int i = 0;
+    QBENCHMARK {
+        form->setValueAt(mLeafPath, ++i % 100);
+    }
+}
+
+void FormsBenchmark::valueString()
+{
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    form->setValue(mValue);
+    bool other = false;
+    QBENCHMARK {
+        // a changed leaf invalidates the cached strings along its path only
+        form->setValueAt(mLeafPath, other ? 1 : 2);
+        other = ! other;
+        form->valueString();
+    }
+}
+
+void FormsBenchmark::writeValueString()
+{
+    QScopedPointer<FormGenElement> form(createForm(mDepth));
+    form->setValue(mValue);
+    QBENCHMARK {
+        QString buffer;
+        FormGenWriter writer(&buffer);
+        form->writeValueString(writer);
+        writer.flush();
+    }
+}
+
+void FormsBenchmark::schemaAcceptsValue()
+{
+    QScopedPointer<FormGenSchemaNode> schema(createSchema(mDepth));
+    QBENCHMARK {
+        schema->acceptsValue(mValue);
+    }
+}
+
+void FormsBenchmark::schemaValidate()
+{
+    QScopedPointer<FormGenSchemaNode> schema(createSchema(mDepth));
+    QBENCHMARK {
+        schema->validate(mValue);
+    }
+}
+
+void FormsBenchmark::quotedString_data()
+{
+    QTest::addColumn<int>("length");
+    QTest::addColumn<int>("escapeEvery");
+    QTest::newRow("short clean") << 16 << 0;
+    QTest::newRow("short dense") << 16 << 10;
+    QTest::newRow("long clean") << 64 * 1024 << 0;
+    QTest::newRow("long rare") << 64 * 1024 << 1000;
+    QTest::newRow("long dense") << 64 * 1024 << 10;
+}
+
+// length letters, with a quote every escapeEvery characters (none for 0)
+QString FormsBenchmark::quotedStringInput(int length, int escapeEvery)
+{
+    QString s;
+    s.reserve(length);
+    for( int i = 0; i < length; ++i )
+        s.append(escapeEvery && i % escapeEvery == 0 ? QLatin1Char('"') : QLatin1Char(char('a' + i % 26)));
+    return s;
+}
+
+// FormGenSchemaBase::quotedString with the escape scan done one character at a time, the
+// baseline for its SSE2/AVX2 scan
+QString FormsBenchmark::scalarQuotedString(const QString &s)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    const QChar *data = s.constData();
+    const int size = s.size();
+    const auto escaped = [] (ushort c) { return c < 0x20 || c == 0x22 || c == 0x5C; };
+
+    int resultSize = size + 2;
+    for( int i = 0; i < size; ++i ) {
+        if( escaped(data[i].unicode()) )
+            resultSize += data[i].unicode() < 0x20 ? 5 : 1;
+    }
+
+    QString result(resultSize, Qt::Uninitialized);
+    QChar *out = result.data();
+    *out++ = QLatin1Char('"');
+    for( int i = 0; i < size; ++i ) {
+        const ushort c = data[i].unicode();
+        if( ! escaped(c) ) {
+            *out++ = data[i];
+            continue;
+        }
+        *out++ = QLatin1Char('\\');
+        if( c < 0x20 ) {
+            *out++ = QLatin1Char('u');
+            *out++ = QLatin1Char('0');
+            *out++ = QLatin1Char('0');
+            *out++ = QLatin1Char(hexDigits[(c >> 4) & 15]);
+            *out++ = QLatin1Char(hexDigits[c & 15]);
+        } else {
+            *out++ = QChar(c);
+        }
+    }
+    *out = QLatin1Char('"');
+    return result;
+}
+
+void FormsBenchmark::quotedString()
+{
+    QFETCH(int, length);
+    QFETCH(int, escapeEvery);
+    const QString s = quotedStringInput(length, escapeEvery);
+    QBENCHMARK {
+        FormGenSchemaBase::quotedString(s);
+    }
+}
+
+void FormsBenchmark::quotedStringScalar()
+{
+    QFETCH(int, length);
+    QFETCH(int, escapeEvery);
+    const QString s = quotedStringInput(length, escapeEvery);
+    QCOMPARE(scalarQuotedString(s), FormGenSchemaBase::quotedString(s));
+    QBENCHMARK {
+        scalarQuotedString(s);
+    }
+}
+
+void FormsBenchmark::fileUrlListSetValue_data()
+{
+    addRowCounts();
+}
+
+void FormsBenchmark::fileUrlListSetValue()
+{
+    QFETCH(int, rows);
+    FormGenFileUrlList list;
+    const QVariant value = urls(rows);
+    QBENCHMARK {
+        list.setValue(value);
+    }
+}
+
+void FormsBenchmark::fileUrlListValueString_data()
+{
+    addRowCounts();
+}
+
+void FormsBenchmark::fileUrlListValueString()
+{
+    QFETCH(int, rows);
+    FormGenFileUrlList list;
+    list.setValue(urls(rows));
+    // valueString() is cached, so render it through the schema like a changed list would
+    QBENCHMARK {
+        list.acceptsValue(list.value()).valueString;
+    }
+}
+
+FORMGEN_BENCHMARK_MAIN(FormsBenchmark)
+
+#include "formsbenchmark.moc"
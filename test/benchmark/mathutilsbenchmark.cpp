@@ -0,0 +1,114 @@
+#include "benchmark.h"
+#include "mathutils.h"
+
+#include <cmath>
+
+// The decimal <-> binary float conversions behind FormGenFloatWidget and the integer parsing.
+class MathUtilsBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void decimalToFloatB64();
+    void decimalToFloatB32();
+    void floatB64ToFloatB32();
+    void floatB64ToString_data();
+    void floatB64ToString();
+    void floatB32ToString();
+    void intDecimalToQVariantInteger();
+    void minLeqValLeqMax();
+
+private:
+    QStringList mDecimals;
+    QVector<double> mDoubles;
+    QStringList mIntegers;
+};
+
+void MathUtilsBenchmark::initTestCase()
+{
+    // a fixed mix of short, long, tiny and huge numbers
+    const int count = benchmarkSetting("MATH_VALUES", 1000);
+    quint32 x = 12345;
+    for( int i = 0; i < count; ++i ) {
+        x = x * 1664525u + 1013904223u;
+        const double d = (double(x) / 4294967296.0 - 0.5) * std::pow(10.0, int(x % 40) - 20);
+        mDoubles.append(d);
+        mDecimals.append(QString::number(d, 'g', 1 + int(x % 17)));
+        mIntegers.append(QString::number(qint64(x) * (x % 2 ? 1 : -1) * qint64(x % 1000)));
+    }
+}
+
+void MathUtilsBenchmark::decimalToFloatB64()
+{
+    double d;
+    QBENCHMARK {
+        for( const auto &s : mDecimals )
+            MathUtils::decimalToFloatB64(s, MathUtils::RoundNearestEven, &d);
+    }
+}
+
+void MathUtilsBenchmark::decimalToFloatB32()
+{
+    float f;
+    QBENCHMARK {
+        for( const auto &s : mDecimals )
+            MathUtils::decimalToFloatB32(s, MathUtils::RoundNearestEven, &f);
+    }
+}
+
+void MathUtilsBenchmark::floatB64ToFloatB32()
+{
+    float f;
+    QBENCHMARK {
+        for( const double d : mDoubles )
+            MathUtils::floatB64ToFloatB32(d, MathUtils::RoundToInf, &f);
+    }
+}
+
+void MathUtilsBenchmark::floatB64ToString_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::newRow("simple") << int(MathUtils::SimpleNotation);
+    QTest::newRow("scientific") << int(MathUtils::ScientificNotation);
+    QTest::newRow("auto") << int(MathUtils::AutoNotation);
+}
+
+void MathUtilsBenchmark::floatB64ToString()
+{
+    QFETCH(int, format);
+    QBENCHMARK {
+        for( const double d : mDoubles )
+            MathUtils::floatB64ToString_RoundTripPrecision(d, MathUtils::NotationFormat(format));
+    }
+}
+
+void MathUtilsBenchmark::floatB32ToString()
+{
+    QBENCHMARK {
+        for( const double d : mDoubles )
+            MathUtils::floatB32ToString_RoundTripPrecision(float(d));
+    }
+}
+
+void MathUtilsBenchmark::intDecimalToQVariantInteger()
+{
+    QBENCHMARK {
+        for( const auto &s : mIntegers )
+            MathUtils::intDecimalToQVariantInteger(s);
+    }
+}
+
+void MathUtilsBenchmark::minLeqValLeqMax()
+{
+    const QVariant min = qint64(-1000000);
+    const QVariant max = quint64(1000000);
+    QBENCHMARK {
+        for( int i = 0; i < mIntegers.size(); ++i )
+            MathUtils::minLeqValLeqMax(min, i % 2 ? QVariant(i) : QVariant(qint64(-i)), max);
+    }
+}
+
+FORMGEN_BENCHMARK_MAIN(MathUtilsBenchmark)
+
+#include "mathutilsbenchmark.moc"
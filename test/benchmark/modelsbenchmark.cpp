@@ -0,0 +1,382 @@
+#include "benchmark.h"
+#include "formgencompositionmodels.h"
+
+#include <QCollator>
+
+// Rows the reconcile and replace benchmarks change: evenly spread, so the two edits per row
+// stay below the edit limit beyond which reconciling resets the model, at every row count.
+static const int s_changedRows = 256;
+
+// The list and bag models behind FormGenListBagComposition, with 10k to 1M rows.
+class ModelsBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void listAppendRows_data() { addRowCounts(); }
+    void listAppendRows();
+    void listReconcile_data() { addRowCounts(); }
+    void listReconcile();
+    void listRemoveRows_data() { addRowCounts(); }
+    void listRemoveRows();
+
+    void bagAppendRows_data() { addStorages(); }
+    void bagAppendRows();
+    void bagInsertRow_data() { addStorages(); }
+    void bagInsertRow();
+    void bagEditRow_data() { addStorages(); }
+    void bagEditRow();
+    void bagReconcile_data() { addRowCounts(); }
+    void bagReconcile();
+    void bagReplaceRows_data() { addRowCounts(); }
+    void bagReplaceRows();
+    void bagRemoveIf_data() { addRowCounts(); }
+    void bagRemoveIf();
+
+    // resorting, alternating between ascending and descending
+    void bagSetCompareOperator_data() { addRowCounts(); }
+    void bagSetCompareOperator();
+    void bagSetCompareFunctor_data() { addRowCounts(); }
+    void bagSetCompareFunctor();
+    void bagSetCompareFunctorParallel_data() { addRowCounts(); }
+    void bagSetCompareFunctorParallel();
+    void bagSetSortKeys_data() { addRowCounts(); }
+    void bagSetSortKeys();
+    void bagSetSortKeysCompare_data() { addRowCounts(); }
+    void bagSetSortKeysCompare();
+
+private:
+    static void addStorages();
+    static void intRows(int rows, QStringList *displays, QVariantList *data);
+    static void recordRows(int rows, QStringList *displays, QVariantList *data);
+    static QVariantList changedRows(const QVariantList &data);
+    static QString display(const QVariant &v) { return v.toString(); }
+    static void resortAlternating(FormGenBagModel &bag, bool parallel, bool functor);
+};
+
+void ModelsBenchmark::addStorages()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("storage");
+
+    const int maxRows = benchmarkSetting("MAX_ROWS", 1000000);
+    const struct { const char *tag; int rows; } counts[] = {
+        { "10k", 10000 }, { "100k", 100000 }, { "1M", 1000000 }
+    };
+    for( const auto &count : counts ) {
+        if( count.rows > maxRows )
+            continue;
+        QTest::newRow(QByteArray(count.tag).append(" vector").constData()) << count.rows << int(FormGenBagModel::VectorStorage);
+        QTest::newRow(QByteArray(count.tag).append(" tree").constData()) << count.rows << int(FormGenBagModel::TreeStorage);
+    }
+}
+
+// rows of scattered ints, displayed as such
+void ModelsBenchmark::intRows(int rows, QStringList *displays, QVariantList *data)
+{
+    displays->reserve(rows);
+    data->reserve(rows);
+    for( int i = 0; i < rows; ++i ) {
+        const int v = int((i * 2654435761u) % 1000003u);
+        displays->append(QString::number(v));
+        data->append(v);
+    }
+}
+
+// records {"i": int, "s": string}, for sorting by sub values
+void ModelsBenchmark::recordRows(int rows, QStringList *displays, QVariantList *data)
+{
+    displays->reserve(rows);
+    data->reserve(rows);
+    for( int i = 0; i < rows; ++i ) {
+        const int v = int((i * 2654435761u) % 1000003u);
+        QVariantHash record;
+        record.insert(QStringLiteral("i"), v % 1000);
+        record.insert(QStringLiteral("s"), QStringLiteral("name %1").arg(v));
+        displays->append(QString::number(v));
+        data->append(record);
+    }
+}
+
+// data with s_changedRows of its rows replaced
+QVariantList ModelsBenchmark::changedRows(const QVariantList &data)
+{
+    const int step = qMax(1, data.size() / s_changedRows);
+    QVariantList changed = data;
+    for( int i = 0; i < changed.size(); i += step )
+        changed[i] = -1 - i;
+    return changed;
+}
+
+void ModelsBenchmark::listAppendRows()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenListModel list;
+    QBENCHMARK {
+        list.clear();
+        list.appendRows(displays, data);
+    }
+}
+
+void ModelsBenchmark::listReconcile()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+    const QVariantList changed = changedRows(data);
+
+    FormGenListModel list;
+    list.resetRows(displays, data);
+    bool other = false;
+    QBENCHMARK {
+        list.reconcile(other ? data : changed, display);
+        other = ! other;
+    }
+}
+
+void ModelsBenchmark::listRemoveRows()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+    QList<int> removed;
+    for( int row = 0; row < rows; row += 100 )
+        removed.append(row);
+
+    FormGenListModel list;
+    list.resetRows(displays, data);
+    QBENCHMARK_ONCE {
+        list.removeRows(removed);
+    }
+}
+
+void ModelsBenchmark::bagAppendRows()
+{
+    QFETCH(int, rows);
+    QFETCH(int, storage);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.setStorage(FormGenBagModel::Storage(storage));
+    QBENCHMARK {
+        bag.clear();
+        bag.appendRows(displays, data);
+    }
+}
+
+void ModelsBenchmark::bagInsertRow()
+{
+    QFETCH(int, rows);
+    QFETCH(int, storage);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.setStorage(FormGenBagModel::Storage(storage));
+    bag.resetRows(displays, data);
+    int i = 0;
+    QBENCHMARK {
+        const int v = (++i * 7919) % 1000003;
+        bag.removeRow(bag.insertRow(QString::number(v), v));
+    }
+}
+
+void ModelsBenchmark::bagEditRow()
+{
+    QFETCH(int, rows);
+    QFETCH(int, storage);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.setStorage(FormGenBagModel::Storage(storage));
+    bag.resetRows(displays, data);
+    int i = 0;
+    QBENCHMARK {
+        // moves rows across the whole bag
+        const int v = (++i * 7919) % 1000003;
+        bag.editRow((i * 104729) % rows, QString::number(v), v);
+    }
+}
+
+void ModelsBenchmark::bagReconcile()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+    const QVariantList changed = changedRows(data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    bool other = false;
+    QBENCHMARK {
+        bag.reconcile(other ? data : changed, display);
+        other = ! other;
+    }
+}
+
+void ModelsBenchmark::bagReplaceRows()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+    const QVariantList changed = changedRows(data);
+    QStringList changedDisplays;
+    for( const auto &v : changed )
+        changedDisplays.append(display(v));
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    bool other = false;
+    QBENCHMARK {
+        if( other )
+            bag.replaceRows(displays, data);
+        else
+            bag.replaceRows(changedDisplays, changed);
+        other = ! other;
+    }
+}
+
+void ModelsBenchmark::bagRemoveIf()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    QBENCHMARK_ONCE {
+        bag.removeIf([] (const QVariant &v) { return v.toInt() % 100 == 0; });
+    }
+}
+
+void ModelsBenchmark::resortAlternating(FormGenBagModel &bag, bool parallel, bool functor)
+{
+    bag.setParallelSorting(parallel);
+    const auto ascending = [] (const FormGenBagModel::DataElement &lhs, const FormGenBagModel::DataElement &rhs) {
+        return lhs.second.toInt() < rhs.second.toInt();
+    };
+    const auto descending = [] (const FormGenBagModel::DataElement &lhs, const FormGenBagModel::DataElement &rhs) {
+        return rhs.second.toInt() < lhs.second.toInt();
+    };
+    const FormGenBagModel::Compare ascendingOperator{FormGenBagModel::Compare::Func(ascending)};
+    const FormGenBagModel::Compare descendingOperator{FormGenBagModel::Compare::Func(descending)};
+
+    bool other = false;
+    QBENCHMARK {
+        if( functor ) {
+            if( other )
+                bag.setCompareFunctor(descending);
+            else
+                bag.setCompareFunctor(ascending);
+        } else {
+            bag.setCompareOperator(other ? descendingOperator : ascendingOperator);
+        }
+        other = ! other;
+    }
+}
+
+void ModelsBenchmark::bagSetCompareOperator()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    resortAlternating(bag, false, false);
+}
+
+void ModelsBenchmark::bagSetCompareFunctor()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    resortAlternating(bag, false, true);
+}
+
+void ModelsBenchmark::bagSetCompareFunctorParallel()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    intRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    resortAlternating(bag, true, true);
+}
+
+void ModelsBenchmark::bagSetSortKeys()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    recordRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    const QVector<FormGenBagModel::SortKey> byNumber = { {QStringLiteral("i"), FormGenBagModel::Ascending},
+                                                         {QStringLiteral("s"), FormGenBagModel::Descending} };
+    const QVector<FormGenBagModel::SortKey> byName = { {QStringLiteral("s"), FormGenBagModel::Ascending} };
+    bool other = false;
+    QBENCHMARK {
+        bag.setSortKeys(other ? byName : byNumber);
+        other = ! other;
+    }
+}
+
+// the orders of bagSetSortKeys through setCompareOperator, looking the fields up and
+// collating them on every comparison
+void ModelsBenchmark::bagSetSortKeysCompare()
+{
+    QFETCH(int, rows);
+    QStringList displays;
+    QVariantList data;
+    recordRows(rows, &displays, &data);
+
+    FormGenBagModel bag;
+    bag.resetRows(displays, data);
+    const QCollator collator;
+    const auto byNumber = [&collator] (const FormGenBagModel::DataElement &lhs, const FormGenBagModel::DataElement &rhs) {
+        const QVariantHash l = lhs.second.toHash();
+        const QVariantHash r = rhs.second.toHash();
+        const int li = l.value(QStringLiteral("i")).toInt();
+        const int ri = r.value(QStringLiteral("i")).toInt();
+        if( li != ri )
+            return li < ri;
+        return collator.compare(r.value(QStringLiteral("s")).toString(), l.value(QStringLiteral("s")).toString()) < 0;
+    };
+    const auto byName = [&collator] (const FormGenBagModel::DataElement &lhs, const FormGenBagModel::DataElement &rhs) {
+        return collator.compare(lhs.second.toHash().value(QStringLiteral("s")).toString(),
+                                rhs.second.toHash().value(QStringLiteral("s")).toString()) < 0;
+    };
+    const FormGenBagModel::Compare byNumberOperator{FormGenBagModel::Compare::Func(byNumber)};
+    const FormGenBagModel::Compare byNameOperator{FormGenBagModel::Compare::Func(byName)};
+    bool other = false;
+    QBENCHMARK {
+        bag.setCompareOperator(other ? byNameOperator : byNumberOperator);
+        other = ! other;
+    }
+}
+
+FORMGEN_BENCHMARK_MAIN(ModelsBenchmark)
+
+#include "modelsbenchmark.moc"
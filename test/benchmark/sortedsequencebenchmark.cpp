@@ -0,0 +1,266 @@
+#include "benchmark.h"
+#include "eytzinger_index.h"
+#include "order_statistic_tree.h"
+#include "sorted_sequence.h"
+
+#include <algorithm>
+#include <vector>
+
+typedef sorted_sequence::adaptor< std::vector<int> > VectorSequence;
+typedef sorted_sequence::adaptor< sorted_sequence::order_statistic_tree<int> > TreeSequence;
+
+// The sorted_sequence containers on 10k to 1M ints, vector against order statistic tree.
+class SortedSequenceBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void insert_data() { addStorages(); }
+    void insert();
+    void insertRange_data() { addStorages(); }
+    void insertRange();
+    void change_data() { addStorages(); }
+    void change();
+    void removeIf_data() { addStorages(); }
+    void removeIf();
+    void sort_data() { addRowCounts(); }
+    void sort();
+    void sortParallel_data() { addRowCounts(); }
+    void sortParallel();
+
+    // lookups of mQueries in a vector sequence
+    void lowerBoundStd_data() { addRowCounts(); }
+    void lowerBoundStd();
+    void lowerBoundAdaptor_data() { addRowCounts(); }
+    void lowerBoundAdaptor();
+    void lowerBoundEytzinger_data() { addRowCounts(); }
+    void lowerBoundEytzinger();
+
+    void mergeWith_data() { addRowCounts(); }
+    void mergeWith();
+    void differenceRanges_data() { addRowCounts(); }
+    void differenceRanges();
+
+private:
+    static void addStorages();
+    static std::vector<int> values(int count, unsigned seed);
+    template< class Sequence > static void insert(int rows);
+    template< class Sequence > static void insertRange(int rows);
+    template< class Sequence > static void change(int rows);
+    template< class Sequence > static void removeIf(int rows);
+
+    std::vector<int> mQueries;
+};
+
+void SortedSequenceBenchmark::initTestCase()
+{
+    mQueries = values(benchmarkSetting("QUERIES", 10000), 7);
+}
+
+void SortedSequenceBenchmark::addStorages()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("tree");
+
+    const int maxRows = benchmarkSetting("MAX_ROWS", 1000000);
+    const struct { const char *tag; int rows; } counts[] = {
+        { "10k", 10000 }, { "100k", 100000 }, { "1M", 1000000 }
+    };
+    for( const auto &count : counts ) {
+        if( count.rows > maxRows )
+            continue;
+        QTest::newRow(QByteArray(count.tag).append(" vector").constData()) << count.rows << false;
+        QTest::newRow(QByteArray(count.tag).append(" tree").constData()) << count.rows << true;
+    }
+}
+
+std::vector<int> SortedSequenceBenchmark::values(int count, unsigned seed)
+{
+    std::vector<int> result;
+    result.reserve(count);
+    unsigned x = seed;
+    for( int i = 0; i < count; ++i ) {
+        x = x * 1664525u + 1013904223u;
+        result.push_back(int(x >> 4));
+    }
+    return result;
+}
+
+template< class Sequence >
+void SortedSequenceBenchmark::insert(int rows)
+{
+    const std::vector<int> initial = values(rows, 1);
+    Sequence sequence(typename Sequence::container_type(initial.begin(), initial.end()));
+    const std::vector<int> inserted = values(1000, 2);
+    QBENCHMARK {
+        for( const int v : inserted )
+            sequence.removeAt(sequence.insert(v));
+    }
+}
+
+template< class Sequence >
+void SortedSequenceBenchmark::insertRange(int rows)
+{
+    std::vector<int> initial = values(rows, 1);
+    std::sort(initial.begin(), initial.end());
+    const std::vector<int> batch = values(rows / 100, 2);
+    QBENCHMARK {
+        Sequence sequence(sorted_sequence::presorted, typename Sequence::container_type(initial.begin(), initial.end()));
+        sequence.insertRange(batch.begin(), batch.end());
+    }
+}
+
+template< class Sequence >
+void SortedSequenceBenchmark::change(int rows)
+{
+    const std::vector<int> initial = values(rows, 1);
+    Sequence sequence(typename Sequence::container_type(initial.begin(), initial.end()));
+    const std::vector<int> changed = values(1000, 2);
+    QBENCHMARK {
+        // small moves, as when editing a row of a bag
+        for( std::size_t i = 0; i < changed.size(); ++i ) {
+            const auto row = typename Sequence::index(changed[i] % rows);
+            sequence.change(row, sequence.at(row) + changed[i] % 1024 - 512);
+        }
+    }
+}
+
+template< class Sequence >
+void SortedSequenceBenchmark::removeIf(int rows)
+{
+    std::vector<int> initial = values(rows, 1);
+    std::sort(initial.begin(), initial.end());
+    QBENCHMARK {
+        Sequence sequence(sorted_sequence::presorted, typename Sequence::container_type(initial.begin(), initial.end()));
+        sequence.removeIf([] (int v) { return v % 16 == 0; });
+    }
+}
+
+void SortedSequenceBenchmark::insert()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, tree);
+    if( tree )
+        insert<TreeSequence>(rows);
+    else
+        insert<VectorSequence>(rows);
+}
+
+void SortedSequenceBenchmark::insertRange()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, tree);
+    if( tree )
+        insertRange<TreeSequence>(rows);
+    else
+        insertRange<VectorSequence>(rows);
+}
+
+void SortedSequenceBenchmark::change()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, tree);
+    if( tree )
+        change<TreeSequence>(rows);
+    else
+        change<VectorSequence>(rows);
+}
+
+void SortedSequenceBenchmark::removeIf()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, tree);
+    if( tree )
+        removeIf<TreeSequence>(rows);
+    else
+        removeIf<VectorSequence>(rows);
+}
+
+void SortedSequenceBenchmark::sort()
+{
+    QFETCH(int, rows);
+    const std::vector<int> initial = values(rows, 1);
+    QBENCHMARK {
+        std::vector<int> v = initial;
+        sorted_sequence::sort_container<sorted_sequence::default_sort_algorithm>(v, std::less<int>());
+    }
+}
+
+void SortedSequenceBenchmark::sortParallel()
+{
+    QFETCH(int, rows);
+    const std::vector<int> initial = values(rows, 1);
+    QBENCHMARK {
+        std::vector<int> v = initial;
+        sorted_sequence::sort_container< sorted_sequence::parallel_stable_sort_algorithm<> >(v, std::less<int>());
+    }
+}
+
+void SortedSequenceBenchmark::lowerBoundStd()
+{
+    QFETCH(int, rows);
+    std::vector<int> v = values(rows, 1);
+    std::sort(v.begin(), v.end());
+    std::ptrdiff_t sum = 0;
+    QBENCHMARK {
+        for( const int q : mQueries )
+            sum += std::lower_bound(v.begin(), v.end(), q) - v.begin();
+    }
+    QVERIFY(sum >= 0);
+}
+
+void SortedSequenceBenchmark::lowerBoundAdaptor()
+{
+    QFETCH(int, rows);
+    const VectorSequence sequence(values(rows, 1));
+    std::ptrdiff_t sum = 0;
+    QBENCHMARK {
+        for( const int q : mQueries )
+            sum += sequence.insertPosition(q, sorted_sequence::InsertFirst);
+    }
+    QVERIFY(sum >= 0);
+}
+
+void SortedSequenceBenchmark::lowerBoundEytzinger()
+{
+    QFETCH(int, rows);
+    const VectorSequence sequence(values(rows, 1));
+    const sorted_sequence::eytzinger_index<VectorSequence> index(sequence);
+    index.sync();
+    std::ptrdiff_t sum = 0;
+    QBENCHMARK {
+        for( const int q : mQueries )
+            sum += index.lowerBound(q);
+    }
+    QVERIFY(sum >= 0);
+}
+
+void SortedSequenceBenchmark::mergeWith()
+{
+    QFETCH(int, rows);
+    const VectorSequence a(values(rows, 1));
+    const VectorSequence b(values(rows, 2));
+    QBENCHMARK {
+        a.mergeWith(b);
+    }
+}
+
+void SortedSequenceBenchmark::differenceRanges()
+{
+    QFETCH(int, rows);
+    // two snapshots differing in every 100th value
+    std::vector<int> changed = values(rows, 1);
+    for( std::size_t i = 0; i < changed.size(); i += 100 )
+        changed[i] = -changed[i];
+    const VectorSequence a(values(rows, 1));
+    const VectorSequence b(changed);
+    QBENCHMARK {
+        a.differenceRanges(b);
+        b.differenceRanges(a);
+    }
+}
+
+FORMGEN_BENCHMARK_MAIN(SortedSequenceBenchmark)
+
+#include "sortedsequencebenchmark.moc"
@@ -39,9 +39,7 @@ int main(int argc, char *argv[])
         rec->addElement("s", new FormGenTextWidget);
         list->setContentElement(rec, "Current entry");
         test->addElement("list", list);
-        list->setCompareOperator(FormGenBagModel::Compare([] (const FormGenBagModel::DataElement& x, const FormGenBagModel::DataElement& y) {
-            return x.second.toHash().value("i").toInt() < y.second.toHash().value("i").toInt();
-        }));
+        list->setSortKeys({ {"i", FormGenBagModel::Ascending}, {"s", FormGenBagModel::Descending} });
     }
     test->connect(test, &FormGenElement::valueChanged, [&test] { qDebug() << test->valueString(); } );
 